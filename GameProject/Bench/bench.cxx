@@ -0,0 +1,316 @@
+/*! \file bench.cxx
+ * Benchmark suite: runs every generator over a matrix of map sizes and
+ * iteration counts with the same seed, discards the warmup runs and times
+ * each repetition by wall clock and by CPU time. Median, p95 and p99 with
+ * their confidence intervals go to stdout as a table and, on request, to
+ * JSON and CSV files, so runs before and after a change compare directly.
+ * Setting up a run (clearing the map, the fault base under erosion) is not
+ * timed.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <getopt.h>
+#include <string>
+#include <vector>
+
+#include "options.h"
+#include "heightmap.h"
+#include "threadpool.h"
+#include "benchstats.h"
+#include "diamondsquare.h"
+#include "midpoint.h"
+#include "fault.h"
+#include "particle.h"
+#include "perlin.h"
+#include "erosion.h"
+
+const int PERLIN_OCTAVES = 16;
+const int EROSION_BASE_FAULTS = 500;    // as the erosion batch program
+
+/******************************************************************************
+ * Run: what one timed repetition works on.
+ ******************************************************************************/
+struct Run {
+    Heightmap map;
+    Heightmap water;
+    uint32_t seed;
+    int iterations;
+    ThreadPool *pool;
+};
+
+/******************************************************************************
+ * Generator: one benchmark row family. setup is untimed and must leave the
+ * run as a fresh program would; iterative generators are timed once per
+ * iteration count, the rest once per size.
+ ******************************************************************************/
+struct Generator {
+    const char *name;
+    bool needsPowerOfTwoPlusOne;
+    bool iterative;
+    void (*setup)(Run &run);
+    void (*run)(Run &run);
+};
+
+static void clearMap(Run &run){
+    run.map.fill(0.0f);
+}
+
+static void erosionBase(Run &run){
+    run.map.fill(0.0f);
+    faultLines(run.map, run.seed, EROSION_BASE_FAULTS, FAULT_ROWS, run.pool);
+    if (run.water.width() != run.map.width())
+        run.water.allocate(run.map.width(), run.map.height());
+    run.water.fill(0.0f);
+}
+
+static void runDiamond(Run &run){ diamondSquare(run.map, run.seed, run.pool); }
+static void runMidpoint(Run &run){ midpointDisplacement(run.map, run.seed); }
+static void runFault(Run &run){ faultLines(run.map, run.seed, run.iterations, FAULT_ROWS, run.pool); }
+static void runParticle(Run &run){
+    particleDeposition(run.map, run.seed, run.iterations, PARTICLE_SINGLE, run.pool);
+}
+static void runPerlin(Run &run){ perlinNoise(run.map, run.seed, PERLIN_OCTAVES); }
+static void runErosion(Run &run){ waterErosion(run.map, run.water, run.iterations, run.pool); }
+
+static const Generator generators[] = {
+    { "diamond",  true,  false, clearMap,    runDiamond },
+    { "midpoint", true,  false, clearMap,    runMidpoint },
+    { "fault",    false, true,  clearMap,    runFault },
+    { "particle", false, true,  clearMap,    runParticle },
+    { "perlin",   false, false, clearMap,    runPerlin },
+    { "erosion",  false, true,  erosionBase, runErosion },
+};
+static const int GENERATORS = sizeof(generators) / sizeof(generators[0]);
+
+/******************************************************************************
+ * Result: the timings of one generator, size and iteration count.
+ ******************************************************************************/
+struct Result {
+    const char *generator;
+    int size;
+    int iterations;         // 0 for generators without
+    BenchSummary wall, cpu;
+};
+
+/******************************************************************************
+ * toList: comma separated positive integers. False on anything else.
+ ******************************************************************************/
+static bool toList(const char *s, std::vector<int> &values){
+    values.clear();
+    while (*s != '\0'){
+        char *end;
+        long v = strtol(s, &end, 10);
+        if (end == s || v <= 0 || (*end != ',' && *end != '\0'))
+            return false;
+        values.push_back(v);
+        s = *end == ',' ? end + 1 : end;
+    }
+    return !values.empty();
+}
+
+/******************************************************************************
+ * toCount: strict integer conversion, at least least.
+ ******************************************************************************/
+static bool toCount(const char *s, long least, long &value){
+    char *end;
+    value = strtol(s, &end, 10);
+    return *s != '\0' && *end == '\0' && value >= least;
+}
+
+static bool selected(const char *name, const char *only){
+    if (only == NULL)
+        return true;
+    std::string list = std::string(",") + only + ",";
+    return list.find(std::string(",") + name + ",") != std::string::npos;
+}
+
+static void usage(const char *prog){
+    fprintf(stderr, "usage: %s [options]\n", prog);
+    fprintf(stderr, "  -s, --sizes LIST       map sizes (default 129,257)\n");
+    fprintf(stderr, "  -n, --iterations LIST  faults, particles or erosion steps (default 100,1000)\n");
+    fprintf(stderr, "  -g, --only LIST        generators to run, of diamond, midpoint, fault,\n"
+                    "                         particle, perlin and erosion (default all)\n");
+    fprintf(stderr, "  -k, --reps N           timed repetitions (default 10)\n");
+    fprintf(stderr, "  -w, --warmup N         untimed runs first (default 2)\n");
+    fprintf(stderr, "  -r, --seed N           random seed (default 1)\n");
+    fprintf(stderr, "  -j, --threads N        worker threads, 0 for one per core (default 1)\n");
+    fprintf(stderr, "  -J, --json FILE        write the results as JSON\n");
+    fprintf(stderr, "  -C, --csv FILE         write the results as CSV\n");
+}
+
+/******************************************************************************
+ * jsonNumber: v, or null for an unbounded side of an interval, which JSON
+ * has no number for.
+ ******************************************************************************/
+static void jsonNumber(FILE *fp, double v){
+    if (isfinite(v))
+        fprintf(fp, "%.9f", v);
+    else
+        fprintf(fp, "null");
+}
+
+static void jsonQuantile(FILE *fp, const char *name, const Quantile &q){
+    fprintf(fp, "\"%s\": %.9f, \"%s_ci\": [", name, q.value, name);
+    jsonNumber(fp, q.low);
+    fprintf(fp, ", ");
+    jsonNumber(fp, q.high);
+    fprintf(fp, "]");
+}
+
+static void jsonSummary(FILE *fp, const char *clock, const BenchSummary &s){
+    fprintf(fp, "\"%s\": {\"mean\": %.9f, \"stddev\": %.9f, \"min\": %.9f, \"max\": %.9f, ",
+            clock, s.mean, s.stddev, s.min, s.max);
+    jsonQuantile(fp, "median", s.median);
+    fprintf(fp, ", ");
+    jsonQuantile(fp, "p95", s.p95);
+    fprintf(fp, ", ");
+    jsonQuantile(fp, "p99", s.p99);
+    fprintf(fp, "}");
+}
+
+static bool writeJson(const char *path, const std::vector<Result> &results,
+                      uint32_t seed, int threads, int reps, int warmup){
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+        return false;
+    fprintf(fp, "{\n  \"seed\": %u, \"threads\": %d, \"reps\": %d, \"warmup\": %d,\n  \"results\": [\n",
+            seed, threads, reps, warmup);
+    for (size_t i = 0; i < results.size(); i++){
+        const Result &r = results[i];
+        fprintf(fp, "    {\"generator\": \"%s\", \"size\": %d, \"iterations\": %d,\n     ",
+                r.generator, r.size, r.iterations);
+        jsonSummary(fp, "wall", r.wall);
+        fprintf(fp, ",\n     ");
+        jsonSummary(fp, "cpu", r.cpu);
+        fprintf(fp, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    return fclose(fp) == 0;
+}
+
+static bool writeCsv(const char *path, const std::vector<Result> &results){
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+        return false;
+    fprintf(fp, "generator,size,iterations,clock,reps,mean,stddev,min,max,"
+                "median,median_lo,median_hi,p95,p95_lo,p95_hi,p99,p99_lo,p99_hi\n");
+    for (size_t i = 0; i < results.size(); i++){
+        for (int c = 0; c < 2; c++){
+            const Result &r = results[i];
+            const BenchSummary &s = c == 0 ? r.wall : r.cpu;
+            fprintf(fp, "%s,%d,%d,%s,%d,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f\n",
+                    r.generator, r.size, r.iterations, c == 0 ? "wall" : "cpu", s.count,
+                    s.mean, s.stddev, s.min, s.max, s.median.value, s.median.low, s.median.high,
+                    s.p95.value, s.p95.low, s.p95.high, s.p99.value, s.p99.low, s.p99.high);
+        }
+    }
+    return fclose(fp) == 0;
+}
+
+/******************************************************************************
+ * main: main function for the program.
+ ******************************************************************************/
+int main (int argc, char* argv[]) {
+    static struct option longopts[] = {
+        { "sizes",      required_argument, NULL, 's' },
+        { "iterations", required_argument, NULL, 'n' },
+        { "only",       required_argument, NULL, 'g' },
+        { "reps",       required_argument, NULL, 'k' },
+        { "warmup",     required_argument, NULL, 'w' },
+        { "seed",       required_argument, NULL, 'r' },
+        { "threads",    required_argument, NULL, 'j' },
+        { "json",       required_argument, NULL, 'J' },
+        { "csv",        required_argument, NULL, 'C' },
+        { "help",       no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    std::vector<int> sizes, iterations;
+    toList("129,257", sizes);
+    toList("100,1000", iterations);
+    const char *only = NULL, *json = NULL, *csv = NULL;
+    int reps = 10, warmup = 2, threads = 1;
+    uint32_t seed = 1;
+    long value = 0;
+    int ch;
+    while ((ch = getopt_long(argc, argv, "s:n:g:k:w:r:j:J:C:h", longopts, NULL)) != -1){
+        bool ok = true;
+        switch(ch)
+        {
+            case 's': ok = toList(optarg, sizes); break;
+            case 'n': ok = toList(optarg, iterations); break;
+            case 'g': only = optarg; break;
+            case 'k': ok = toCount(optarg, 1, value); reps = value; break;
+            case 'w': ok = toCount(optarg, 0, value); warmup = value; break;
+            case 'r': ok = toCount(optarg, 0, value); seed = (uint32_t)value; break;
+            case 'j': ok = toCount(optarg, 0, value); threads = value; break;
+            case 'J': json = optarg; break;
+            case 'C': csv = optarg; break;
+            default: ok = false;
+        }
+        if (!ok){
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc){
+        usage(argv[0]);
+        return 1;
+    }
+
+    ThreadPool pool(threads);
+    std::vector<Result> results;
+    printf("%-9s %6s %6s %4s  %-49s  %s\n", "", "", "", "", "wall seconds", "cpu seconds");
+    printf("%-9s %6s %6s %4s  %9s %-21s %9s %9s  %9s %-21s %9s %9s\n", "generator", "size", "iters",
+           "reps", "median", " [95% CI]", "p95", "p99", "median", " [95% CI]", "p95", "p99");
+    for (int g = 0; g < GENERATORS; g++){
+        const Generator &gen = generators[g];
+        if (!selected(gen.name, only))
+            continue;
+        for (size_t s = 0; s < sizes.size(); s++){
+            if (gen.needsPowerOfTwoPlusOne && !isPowerOfTwoPlusOne(sizes[s]))
+                continue;
+            for (size_t i = 0; i < (gen.iterative ? iterations.size() : 1); i++){
+                Run run;
+                run.map.allocate(sizes[s], sizes[s]);
+                run.seed = seed;
+                run.iterations = gen.iterative ? iterations[i] : 0;
+                run.pool = &pool;
+
+                std::vector<double> wall, cpu;
+                for (int k = 0; k < warmup + reps; k++){
+                    gen.setup(run);
+                    double w0 = wallClock(), c0 = cpuClock();
+                    gen.run(run);
+                    double w1 = wallClock(), c1 = cpuClock();
+                    if (k >= warmup){
+                        wall.push_back(w1 - w0);
+                        cpu.push_back(c1 - c0);
+                    }
+                }
+                Result r = { gen.name, sizes[s], run.iterations, summarize(wall), summarize(cpu) };
+                results.push_back(r);
+                printf("%-9s %6d %6d %4d  %9.6f [%9.6f %9.6f] %9.6f %9.6f  "
+                       "%9.6f [%9.6f %9.6f] %9.6f %9.6f\n",
+                       r.generator, r.size, r.iterations, r.wall.count,
+                       r.wall.median.value, r.wall.median.low, r.wall.median.high,
+                       r.wall.p95.value, r.wall.p99.value,
+                       r.cpu.median.value, r.cpu.median.low, r.cpu.median.high,
+                       r.cpu.p95.value, r.cpu.p99.value);
+                fflush(stdout);
+            }
+        }
+    }
+
+    if (json != NULL && !writeJson(json, results, seed, pool.size(), reps, warmup)){
+        perror(json);
+        return 1;
+    }
+    if (csv != NULL && !writeCsv(csv, results)){
+        perror(csv);
+        return 1;
+    }
+    return 0;
+}
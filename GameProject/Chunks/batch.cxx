@@ -0,0 +1,131 @@
+/*! \file batch.cxx
+ * Chunked terrain: headless walk through an unbounded map. A camera moves
+ * east along a wave, one step per frame, and asks the chunk scheduler for
+ * every chunk within VIEW_RADIUS of it, nearest first; chunks it left
+ * behind are cancelled. Frames never wait for a chunk: the ones not ready
+ * yet are counted as late. The walk time, the late chunks, the scheduler
+ * and cache counts and the most memory the cache ever held go to stdout,
+ * followed by the number of shared chunk borders that did not match
+ * (always 0).
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "options.h"
+#include "chunk.h"
+#include "scheduler.h"
+
+const int VIEW_RADIUS = 3;          // chunks each side of the camera's chunk
+const int PERLIN_OCTAVES = 6;
+const float CAMERA_SPEED = 0.125f;  // chunks per step
+const float CAMERA_SWAY = 8.0f;     // chunks either side of the z axis
+const int FRAME_MS = 2;             // time the viewer would spend drawing
+
+/******************************************************************************
+ * camera: the chunk the camera is over at step.
+ ******************************************************************************/
+static void camera(int step, int &cx, int &cz){
+    cx = (int)floor(step * CAMERA_SPEED);
+    cz = (int)floor(CAMERA_SWAY * sin(step * 0.005f));
+}
+
+/******************************************************************************
+ * seams: borders of cached chunk (cx, cz) that differ from its right and
+ * lower neighbours, where those are cached too.
+ ******************************************************************************/
+static int seams(ChunkCache &cache, int cx, int cz){
+    const int last = cache.source().size() - 1;
+    ChunkCache::Chunk chunk = cache.find(cx, cz);
+    ChunkCache::Chunk right = cache.find(cx + 1, cz);
+    ChunkCache::Chunk below = cache.find(cx, cz + 1);
+    int bad = 0;
+    if (!chunk)
+        return 0;
+    for (int k = 0; k <= last; k++){
+        if (right && (*chunk)[k][last] != (*right)[k][0])
+            bad++;
+        if (below && (*chunk)[last][k] != (*below)[0][k])
+            bad++;
+    }
+    return bad;
+}
+
+/******************************************************************************
+ * main: main function for the program.
+ ******************************************************************************/
+int main (int argc, char* argv[]) {
+    const Options defaults = { 129, (unsigned int)time(NULL), 2000, NULL, NULL, 1 };
+    Options opts = defaults;
+    double t1,t2;
+
+    if (!parseOptions(argc, argv, opts)) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+    std::unique_ptr<ChunkSource> source(newChunkSource(opts.method != NULL ? opts.method : "perlin",
+                                                       opts.size, opts.seed, PERLIN_OCTAVES));
+    if (!source) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+    //room for the view and as much again, so turning back is mostly hits
+    const int view = 2*VIEW_RADIUS + 1;
+    ChunkCache cache(*source, 2 * view * view * ChunkCache::chunkBytes(*source));
+    ChunkScheduler scheduler(cache, opts.threads);
+    size_t peak = 0;
+    long late = 0;
+    int worst = 0;
+
+    t1=wallClock();
+    for (int step = 0; step < opts.iterations; step++){
+        int cx, cz;
+        camera(step, cx, cz);
+        auto distance = [cx, cz](int x, int z){
+            return sqrtf((float)((x - cx)*(x - cx) + (z - cz)*(z - cz)));
+        };
+        //just past the corners of the view
+        scheduler.retarget(distance, VIEW_RADIUS * 1.5f);
+        std::vector<ChunkScheduler::Future> chunks = scheduler.requestRegion(
+            cx - VIEW_RADIUS, cz - VIEW_RADIUS, cx + VIEW_RADIUS, cz + VIEW_RADIUS, distance);
+        int missing = 0;
+        for (size_t i = 0; i < chunks.size(); i++)
+            if (chunks[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                missing++;
+        late += missing;
+        if (missing > worst)
+            worst = missing;
+        if (cache.bytes() > peak)
+            peak = cache.bytes();
+        std::this_thread::sleep_for(std::chrono::milliseconds(FRAME_MS));
+    }
+    scheduler.drain();
+    t2=wallClock();
+
+    float seconds = t2 - t1;
+    printf("%f\n", seconds);
+    printf("%s chunks of %d on %d workers: %ld late, at most %d in a frame of %d\n",
+           source->name(), source->size(), scheduler.threads(), late, worst, view * view);
+    printf("%lu generated, %lu coalesced, %lu cancelled\n",
+           scheduler.generated(), scheduler.coalesced(), scheduler.cancelled());
+    printf("cache: %lu hits, %lu misses, peak %.1f MB of a %.1f MB budget\n",
+           cache.hits(), cache.misses(), peak / 1048576.0, cache.budget() / 1048576.0);
+
+    int bad = 0;
+    int cx, cz;
+    camera(opts.iterations - 1, cx, cz);
+    for (int z = cz - VIEW_RADIUS; z < cz + VIEW_RADIUS; z++)
+        for (int x = cx - VIEW_RADIUS; x < cx + VIEW_RADIUS; x++)
+            bad += seams(cache, x, z);
+    printf("seams: %d mismatched samples\n", bad);
+
+    if (opts.times != NULL)
+        appendTime(opts.times, seconds);
+    return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+/*! \file batch.cxx
+ * Hierarchical compression: generates a map with --method (diamond,
+ * midpoint, fault, particle or perlin), codes it with --tolerance as the largest
+ * error and decodes it again one level at a time. The coded size of every
+ * level, the total against the raw floats and the decode time and largest
+ * error go to stdout; --output writes the coded map.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include <vector>
+
+#include "options.h"
+#include "heightmap.h"
+#include "generate.h"
+#include "levelcodec.h"
+
+/******************************************************************************
+ * main: main function for the program.
+ ******************************************************************************/
+int main (int argc, char* argv[]) {
+    const Options defaults = { 1025, (unsigned int)time(NULL), 1000, NULL, NULL,
+                               1, 0, NULL, 0.01f, 0 };
+    Options opts = defaults;
+    double t1,t2;
+
+    if (!parseOptions(argc, argv, opts) || !isPowerOfTwoPlusOne(opts.size) || !(opts.tolerance > 0.0f)) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+    int size = opts.size;
+    Heightmap map(size);
+    ThreadPool pool(opts.threads);
+    if (!generateByName(opts.method != NULL ? opts.method : "diamond", map, opts, &pool)) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+
+    std::vector<unsigned char> coded;
+    t1=wallClock();
+    encodeLevels(map, opts.tolerance, coded);
+    t2=wallClock();
+    double encodeSeconds = t2 - t1;
+
+    LevelDecoder decoder;
+    if (!decoder.open(&coded[0], coded.size())) {
+        fprintf(stderr, "coded map does not read back\n");
+        return 1;
+    }
+    t1=wallClock();
+    while (decoder.refine())
+        printf("level %2d: %5d square, %9lu bytes\n", decoder.decoded() - 1, decoder.lodSize(),
+               (unsigned long)decoder.levelBytes(decoder.decoded() - 1));
+    t2=wallClock();
+
+    float worst = 0.0f;
+    for (int z = 0; z < size; z++)
+        for (int x = 0; x < size; x++)
+            worst = fmaxf(worst, fabsf(decoder.map()[z][x] - map[z][x]));
+    size_t raw = (size_t)size * size * sizeof(float);
+    printf("%lu bytes of %lu raw (%.2f bits per sample), largest error %g\n",
+           (unsigned long)coded.size(), (unsigned long)raw, coded.size() * 8.0 / ((double)size * size),
+           worst);
+    printf("encode %f s, decode %f s\n", encodeSeconds, t2 - t1);
+
+    if (opts.output != NULL) {
+        FILE *fp = fopen(opts.output, "wb");
+        bool ok = fp != NULL && fwrite(&coded[0], 1, coded.size(), fp) == coded.size();
+        if (fp == NULL || fclose(fp) != 0 || !ok) {
+            perror(opts.output);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+/*! \file batch.cxx
+ * Fault Algorithm: headless batch generation. Same generator as main.cxx without
+ * the GLUT window, so it runs on machines with no display or GL libraries.
+ * The generation time goes to stdout and, with --times, to a file.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "options.h"
+#include "heightmap.h"
+#include "mapfile.h"
+#include "fault.h"
+
+/******************************************************************************
+ * main: main function for the program.
+ ******************************************************************************/
+int main (int argc, char* argv[]) { 
+    const Options defaults = { 50, (unsigned int)time(NULL), 500, NULL, NULL, 1 };
+    Options opts = defaults;
+    double t1,t2;
+
+    FaultMethod method = FAULT_ROWS;
+    if (!parseOptions(argc, argv, opts)
+        || (opts.method != NULL && !faultMethodByName(opts.method, method))) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+    int size = opts.size;
+    Heightmap fault(size);
+    ThreadPool pool(opts.threads);
+
+    t1=wallClock();
+    faultLines(fault, opts.seed, opts.iterations, method, &pool);
+    t2=wallClock();
+
+    float seconds = t2 - t1;
+    printf("%f\n", seconds);
+    if (opts.times != NULL)
+        appendTime(opts.times, seconds);
+    if (opts.output != NULL && !saveHeightmap(opts.output, fault, "fault", opts)) {
+        perror(opts.output);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+/*! \file batch.cxx
+ * Level of detail: generates a map with --method (diamond, midpoint,
+ * fault, particle or perlin), builds the LOD tree over it and flies a camera once
+ * round the map, --iterations frames, looking ahead and a little down.
+ * Every frame selects the nodes within --tolerance pixels of screen error
+ * and emits their meshes. The tree build time, the nodes and triangles
+ * drawn per frame against the full grid, and the select and emit times
+ * per frame go to stdout.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#include "options.h"
+#include "heightmap.h"
+#include "generate.h"
+#include "lod.h"
+
+const float FOV_Y = 1.0472f;        // 60 degrees
+const int VIEWPORT_WIDTH = 1920;
+const int VIEWPORT_HEIGHT = 1080;
+const float EYE_HEIGHT = 20.0f;     // above the highest sample
+const float TWO_PI = 6.2831853f;
+const float ORBIT = 0.35f;          // camera path radius as a fraction of the map
+
+/******************************************************************************
+ * main: main function for the program.
+ ******************************************************************************/
+int main (int argc, char* argv[]) {
+    const Options defaults = { 2049, (unsigned int)time(NULL), 360, NULL, NULL,
+                               1, 0, NULL, 1.0f, LOD_LEAF_CELLS };
+    Options opts = defaults;
+    double t1,t2;
+
+    if (!parseOptions(argc, argv, opts) || !isPowerOfTwoPlusOne(opts.size) || !(opts.tolerance > 0.0f)
+        || opts.iterations < 1) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+    int size = opts.size;
+    Heightmap map(size);
+    ThreadPool pool(opts.threads);
+    if (!generateByName(opts.method != NULL ? opts.method : "diamond", map, opts, &pool)) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+
+    LodTree tree;
+    const float half = (float)(size / 2);
+    t1=wallClock();
+    bool built = tree.build(map, -half, -half, 1.0f, opts.levels, &pool);
+    t2=wallClock();
+    if (!built) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+    const LodNode &root = tree.nodes()[0];
+    printf("%lu nodes, %dx%d cells each, root error %g, built in %f s\n",
+           (unsigned long)tree.nodes().size(), tree.leafCells(), tree.leafCells(), root.error, t2 - t1);
+
+    std::vector<LodSelection> selected;
+    LodChunk chunk;
+    size_t fewest = (size_t)-1, most = 0, total = 0;
+    float worst = 0.0f;
+    double selectSeconds = 0.0, emitSeconds = 0.0;
+    for (int frame = 0; frame < opts.iterations; frame++) {
+        float angle = TWO_PI * frame / opts.iterations;
+        float eye[3] = { ORBIT * size * cosf(angle), root.maxHeight + EYE_HEIGHT, ORBIT * size * sinf(angle) };
+        float forward[3] = { -sinf(angle), -0.25f, cosf(angle) };
+        LodView view = lodView(eye, forward, FOV_Y, (float)VIEWPORT_WIDTH / VIEWPORT_HEIGHT,
+                               VIEWPORT_HEIGHT, opts.tolerance);
+        t1=wallClock();
+        tree.select(view, selected);
+        t2=wallClock();
+        selectSeconds += t2 - t1;
+
+        t1=wallClock();
+        for (size_t i = 0; i < selected.size(); i++) {
+            tree.chunk(selected[i].node, chunk);
+            worst = fmaxf(worst, selected[i].screenError);
+        }
+        t2=wallClock();
+        emitSeconds += t2 - t1;
+        fewest = std::min(fewest, selected.size());
+        most = std::max(most, selected.size());
+        total += selected.size();
+    }
+    size_t per = tree.chunkTriangles();
+    printf("nodes per frame: %lu min, %.1f mean, %lu max; largest screen error %g px\n",
+           (unsigned long)fewest, (double)total / opts.iterations, (unsigned long)most, worst);
+    printf("triangles per frame: %lu max, full grid %lu\n",
+           (unsigned long)(most * per), (unsigned long)(2UL * (size - 1) * (size - 1)));
+    printf("select %f ms, emit %f ms per frame\n",
+           1e3 * selectSeconds / opts.iterations, 1e3 * emitSeconds / opts.iterations);
+    return 0;
+}
@@ -0,0 +1,47 @@
+/*! \file batch.cxx
+ * Midpoint Algorithm: headless batch generation. Same generator as main.cxx without
+ * the GLUT window, so it runs on machines with no display or GL libraries.
+ * The generation time goes to stdout and, with --times, to a file.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "options.h"
+#include "heightmap.h"
+#include "mapfile.h"
+#include "smooth.h"
+#include "midpoint.h"
+
+/******************************************************************************
+ * main: main function for the program.
+ ******************************************************************************/
+int main (int argc, char* argv[]) { 
+    const Options defaults = { 33, (unsigned int)time(NULL), 0, NULL, NULL, 1 };
+    Options opts = defaults;
+    double t1,t2;
+
+    if (!parseOptions(argc, argv, opts) || !isPowerOfTwoPlusOne(opts.size)) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+    int size = opts.size;
+    Heightmap midpoint(size);
+
+    t1=wallClock();
+    midpointDisplacement(midpoint, opts.seed, opts.border);
+    t2=wallClock();
+    ThreadPool pool(opts.threads);
+    smooth(midpoint, opts.border, &pool);
+
+    float seconds = t2 - t1;
+    printf("%f\n", seconds);
+    if (opts.times != NULL)
+        appendTime(opts.times, seconds);
+    if (opts.output != NULL && !saveHeightmap(opts.output, midpoint, "midpoint", opts)) {
+        perror(opts.output);
+        return 1;
+    }
+    return 0;
+}
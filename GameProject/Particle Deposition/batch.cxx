@@ -0,0 +1,47 @@
+/*! \file batch.cxx
+ * Particle Algorithm: headless batch generation. Same generator as main.cxx without
+ * the GLUT window, so it runs on machines with no display or GL libraries.
+ * The generation time goes to stdout and, with --times, to a file.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "options.h"
+#include "heightmap.h"
+#include "mapfile.h"
+#include "particle.h"
+
+/******************************************************************************
+ * main: main function for the program.
+ ******************************************************************************/
+int main (int argc, char* argv[]) { 
+    const Options defaults = { 50, (unsigned int)time(NULL), 1000, NULL, NULL, 1 };
+    Options opts = defaults;
+    double t1,t2;
+
+    ParticleMethod method = PARTICLE_SINGLE;
+    if (!parseOptions(argc, argv, opts)
+        || (opts.method != NULL && !particleMethodByName(opts.method, method))) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+    int size = opts.size;
+    Heightmap particle(size);
+    ThreadPool pool(opts.threads);
+
+    t1=wallClock();
+    particleDeposition(particle, opts.seed, opts.iterations, method, &pool);
+    t2=wallClock();
+
+    float seconds = t2 - t1;
+    printf("%f\n", seconds);
+    if (opts.times != NULL)
+        appendTime(opts.times, seconds);
+    if (opts.output != NULL && !saveHeightmap(opts.output, particle, "particle", opts)) {
+        perror(opts.output);
+        return 1;
+    }
+    return 0;
+}
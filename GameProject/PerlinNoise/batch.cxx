@@ -0,0 +1,49 @@
+/*! \file batch.cxx
+ * Perlin Algorithm: headless batch generation. Same generator as main.cxx without
+ * the GLUT window, so it runs on machines with no display or GL libraries.
+ * The generation time goes to stdout and, with --times, to a file.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "options.h"
+#include "heightmap.h"
+#include "mapfile.h"
+#include "smooth.h"
+#include "perlin.h"
+
+/******************************************************************************
+ * main: main function for the program.
+ ******************************************************************************/
+int main (int argc, char* argv[]) { 
+    const Options defaults = { 55, (unsigned int)time(NULL), 16, NULL, NULL, 1 };
+    Options opts = defaults;
+    double t1,t2;
+
+    if (!parseOptions(argc, argv, opts)) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+    int size = opts.size;
+    Heightmap perlin(size);
+
+    OctaveBand band;
+    t1=wallClock();
+    perlinNoise(perlin, opts.seed, opts.iterations, NOISE_AUTO, (BandMode)opts.band, &band);
+    t2=wallClock();
+    ThreadPool pool(opts.threads);
+    smooth(perlin, opts.border, &pool);
+    printOctaveBand(band);
+
+    float seconds = t2 - t1;
+    printf("%f\n", seconds);
+    if (opts.times != NULL)
+        appendTime(opts.times, seconds);
+    if (opts.output != NULL && !saveHeightmap(opts.output, perlin, "perlin", opts)) {
+        perror(opts.output);
+        return 1;
+    }
+    return 0;
+}
@@ -9,142 +9,26 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <iostream>
+#define GL_GLEXT_PROTOTYPES    // buffer objects, see meshdraw.h
 #include <GL/freeglut.h>
 #include <math.h>
 #include <time.h>
 
-using namespace std;
-//perlin129
-const int size = 55;  // 2n+1 ex: 65, 129, 257, 513, 1025             
-const float step = 1.0;                          
-const float MAX_X = step * (size/2);       
-const float MIN_X =  - MAX_X;                       
-const float MAX_Z = step * (size/2);      
-const float MIN_Z =  - MAX_Z;
-const float rand_m = 2147483647.0f; //largest signed integer in 32 bits
+#include "options.h"
+#include "heightmap.h"
+#include "mapfile.h"
+#include "mesh.h"
+#include "meshdraw.h"
+#include "smooth.h"
+#include "perlin.h"
 
-float perlin[size][size]; //heightmap array
-int permutation[512]; //random number array
-static float gradients[8][2] = 
-{
-  { -1.0f, -1.0f }, { 1.0f, 0.0f } , { -1.0f, 0.0f } , { 1.0f, 1.0f } ,
-  { -1.0f, 1.0f } , { 0.0f, -1.0f } , { 0.0f, 1.0f } , { 1.0f, -1.0f }
-};
+int size = 55;  // or --size
+const float step = 1.0;
+float MIN_X, MIN_Z; //set once the size is known
 
-/******************************************************************************
- * random: enter a max value and return a random value between -max, and max.
- ******************************************************************************/
-float random(float max){
-    float r = rand();
-    return (r/rand_m) * max - (max * 0.5);
-}
-
-float dot(float grad[], float x, float y)
-{
-    return (grad[0] * x + grad[1] * y);
-}
-
-float lerp(float t, float a, float b) 
-{ 
-    return a + t * (b - a); 
-}
-
-/******************************************************************************
- * grad: taken directly from Ken Perlin's 2002 SIGGRAPH paper. 
- * http://mrl.nyu.edu/~perlin/noise/
- ******************************************************************************/
-float grad(int h1, float i, float j, float k) {
-  int h = 0; 
-  float u = 0.0f;
-  float v = 0.0f;
-  h = h1 & 15;                     
-  u = h < 8 ? i : j,                 
-  v = h < 4 ? j : h == 12 || h==14 ? i : k;
-  return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
-} 
-
-/******************************************************************************
- * permute: set up random numbers table 
- ******************************************************************************/
-void permute(){ 
-    int p[256];
-    for (int i = 0; i < 256; i++)
-        p[i] = (int)random(256);//put each number in once
-    for (int i = 0; i < 256; i++)
-    {
-        p[256+i] = p[i] = permutation[i];
-    }
-}
-
-/******************************************************************************
- * noise: 2D noise. for each pixel coordindate (i, j) calculate the 
- * dot product of the distance and gradient vectors. Interpolate these noise values
- ******************************************************************************/
-float noise(int i, int j, float freq){
-    int x    = floor(j * freq);
-    int y    = floor(i * freq);
-
-    //fractional grid points
-    float fx = (j * freq) - x;
-    float fy = (i * freq) - y;
-    
-    //indexing into the gradients for the four nearby points
-    int g1   = permutation[(x + permutation[y & 255]) & 255] & 7;
-    int g2   = permutation[(x + 1 + permutation[y & 255]) & 255] & 7;
-    int g3   = permutation[(x + permutation[(y + 1) & 255]) & 255] & 7;
-    int g4   = permutation[(x + 1 + permutation[(y + 1) & 255]) & 255] & 7;//
-    
-    //dot products that get the noise from each corner.
-    float n1 = dot(gradients[g1], fx, fy);
-    float n2 = dot(gradients[g2], fx - 1.0f, fy);
-    float n3 = dot(gradients[g3], fx, fy - 1.0f);
-    float n4 = dot(gradients[g4], fx - 1.0f, fy - 1.0f);
-
-    //fade value calculated by Ken Perlin
-    float sx = fx * fx * fx * (fx * ( 6 * fx - 15) + 10);
-    float sy = fx * fx * fx * (fx * ( 6 * fy - 15) + 10);
-
-    //interpolation along x axis
-    float i1 = lerp(n1, n2, sx);
-    float i2 = lerp(n3, n4, sx);
-
-    return lerp(i1, i2, sy);
-}
-
-/******************************************************************************
- * initHeightField: uses the perlin Algorithm to write heightmap values to 
- * the array perlin. 
- ******************************************************************************/
-void initHeightField() {
-    //initializes the four corners of the map
-    perlin[0][0] = MIN_Z + random(1.0f);
-    perlin[0][size-1] = MIN_Z + random(1.0f);
-    perlin[size-1][0] = MIN_Z + random(1.0f);
-    perlin[size-1][size-1] = MIN_Z + random(1.0f);
-    int oct = 16;  
-    float gain = 0.65f; 
-    float lacunarity = 2.5f;
-
-    float amp, freq, pix;
-   
-    for (int i = 0; i < size; i++)
-    {
-        for (int j = 0; j < size; j++)
-        {
-            amp = 1.0f;
-            freq = 1.0f / (float)size;
-            pix = 0.0f;
-            for (int k = 0; k < oct; ++k)
-            {
-                float lerped = noise(i, j, freq);
-                pix += lerped * amp;
-                amp *= gain;
-                freq *= lacunarity;
-            }
-            perlin[j][i] = pix;
-        }
-    }
-}
+Heightmap perlin; //heightmap array
+TerrainMesh mesh;        // built once the heightmap is done
+MeshBuffers buffers;     // mesh as uploaded to GL
 
 /******************************************************************************
  * display: displays heightmap as 3D terrain
@@ -154,29 +38,8 @@ void display( void ) {
     glClearDepth( 1.0 );
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
     
-    for ( int r = 0; r < size; r++ ) {       
-        float z = MIN_Z + r * step;       
-        for ( int c = 0; c < size; c++ ) {            
-            float x = MIN_X + c * step;
-            if (r < size - 1  &&  c < size - 1  ) {
-                
-                glColor3f( 1.0, 1.0, 1.0 );
-                
-                glBegin( GL_LINE_LOOP );
-                glVertex3f( x, perlin[r][c], z );
-                glVertex3f( x, perlin[r+1][c], z + step );
-                glVertex3f( x + step, perlin[r][c+1], z );
-                glEnd();
-                
-                glBegin( GL_LINE_LOOP );
-                glVertex3f( x + step, perlin[r][c+1], z );
-                glVertex3f( x, perlin[r+1][c], z + step );
-                glVertex3f( x + step, perlin[r+1][c+1], z + step );
-                glEnd();
-            }
-        }
-    }       
-    // Flush output to the screen:
+    glColor3f( 1.0, 1.0, 1.0 );
+    buffers.draw();
     glFlush();
 }
 
@@ -187,43 +50,24 @@ void reshape( const int width, const int height) {
     glViewport( 0, 0, width, height );
 }
 
-void smooth() {
-    int x, y, sum;
-  for (x = 1; x < size - 1; x++)
-    for (y = 1; y < size - 1; y++)
-    {
-      sum = perlin[x][y];
-      sum += perlin[x - 1][(y - 1)];
-      sum += perlin[x][(y - 1)];
-      sum += perlin[x + 1][(y - 1)];
-      sum += perlin[x-1][y];
-      sum += perlin[x+1][y];
-      sum += perlin[x-1][y+1];
-      sum += perlin[x][y+1];
-      sum += perlin[x+1][y+1]; 
-
-      if(sum % 9 > 4)
-        sum = (sum / 9)+1;
-      else 
-        sum = sum / 9;
-      perlin[x][y] = sum;
-    }
-}
-
 /******************************************************************************
  * main: main function for the program.
  ******************************************************************************/
 int main (int argc, char* argv[]) { 
-    time_t beginning = time(NULL);
-    // Writing Files
-    FILE *fp;
-    fp = fopen("perlintest.txt", "a+");//open for writing 
-    
+    const Options defaults = { size, (unsigned int)time(NULL), 16, NULL, "perlintest.txt", 1 };
+    Options opts = defaults;
     clock_t t1,t2;
     // Initialize windows and input:
 
-    srand(beginning);//set the random seed
     glutInit( &argc, argv );
+    if (!parseOptions(argc, argv, opts)) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+    size = opts.size;
+    MIN_X = MIN_Z = - step * (size/2);
+    perlin.allocate(size, size);
+
     glutInitWindowPosition( 200, 0 );
     glutInitWindowSize( 500, 500 );
     glutInitDisplayMode( GLUT_RGBA | GLUT_SINGLE | GLUT_DEPTH );
@@ -240,15 +84,22 @@ int main (int argc, char* argv[]) {
     glLoadIdentity();
     glFrustum( -1.0, 1.0, -1.0, 1.0, 1.0, 100.0 );
     
+    OctaveBand band;
     t1=clock();
-    initHeightField();
+    perlinNoise(perlin, opts.seed, opts.iterations, NOISE_AUTO, (BandMode)opts.band, &band);
     t2=clock();
-    smooth();
+    ThreadPool pool(opts.threads);
+    smooth(perlin, opts.border, &pool);
+    printOctaveBand(band);
     // terrainSmooth(0.75);
     float diff ((float)t2-(float)t1);
     float seconds = diff / CLOCKS_PER_SEC;
-    fprintf(fp, "%f\n", seconds); 
-    fclose(fp);//closing the file
+    appendTime(opts.times, seconds);
+    if (opts.output != NULL && !saveHeightmap(opts.output, perlin, "perlin", opts))
+        perror(opts.output);
+    mesh.build(perlin, MIN_X, MIN_Z, step);
+    buffers.upload(mesh);
+    glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
     glutMainLoop();
     return 0;
 }
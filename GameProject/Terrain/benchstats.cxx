@@ -0,0 +1,69 @@
+/*! \file benchstats.cxx
+ * Summary statistics for benchmark timings.
+ */
+
+#include <math.h>
+#include <algorithm>
+#include "benchstats.h"
+
+static const double TAIL = 0.025;      // allowed miss on each side of a 95% interval
+
+Quantile quantile(const std::vector<double> &sorted, double p){
+    Quantile q = { 0.0, 0.0, 0.0 };
+    const int n = sorted.size();
+    if (n == 0)
+        return q;
+    double at = p * (n - 1);
+    int below = (int)floor(at);
+    int above = below + 1 < n ? below + 1 : below;
+    q.value = sorted[below] + (at - below) * (sorted[above] - sorted[below]);
+
+    //the number of samples under the true quantile is binomial(n, p).
+    //sample l (1 based) is a lower bound unless at least l fall under it, so
+    //l is the highest rank with P(count < l) <= TAIL, and the upper bound
+    //the lowest rank u with P(count >= u) <= TAIL. Without such a rank that
+    //side of the interval is unbounded
+    std::vector<double> under(n + 2, 0.0);    // P(count < k)
+    for (int k = 0; k <= n; k++){
+        double pmf = p <= 0.0 ? (k == 0) : p >= 1.0 ? (k == n)
+                   : exp(lgamma(n + 1.0) - lgamma(k + 1.0) - lgamma(n - k + 1.0)
+                         + k * log(p) + (n - k) * log(1.0 - p));
+        under[k + 1] = under[k] + pmf;
+    }
+    int low = 0, high = n + 1;
+    while (low + 1 <= n && under[low + 1] <= TAIL)
+        low++;
+    while (high - 1 >= 1 && 1.0 - under[high - 1] <= TAIL)
+        high--;
+    q.low = low >= 1 ? sorted[low - 1] : -HUGE_VAL;
+    q.high = high <= n ? sorted[high - 1] : HUGE_VAL;
+    return q;
+}
+
+BenchSummary summarize(std::vector<double> samples){
+    BenchSummary s;
+    const int n = samples.size();
+    s.count = n;
+    s.mean = s.stddev = s.min = s.max = 0.0;
+    const Quantile none = { 0.0, 0.0, 0.0 };
+    s.median = s.p95 = s.p99 = none;
+    if (n == 0)
+        return s;
+
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (int i = 0; i < n; i++)
+        total += samples[i];
+    s.mean = total / n;
+    double squares = 0.0;
+    for (int i = 0; i < n; i++)
+        squares += (samples[i] - s.mean) * (samples[i] - s.mean);
+    //sample standard deviation, unlike average.py's population one
+    s.stddev = n > 1 ? sqrt(squares / (n - 1)) : 0.0;
+    s.min = samples.front();
+    s.max = samples.back();
+    s.median = quantile(samples, 0.5);
+    s.p95 = quantile(samples, 0.95);
+    s.p99 = quantile(samples, 0.99);
+    return s;
+}
@@ -0,0 +1,42 @@
+/*! \file benchstats.h
+ * Summary statistics for benchmark timings. Run times are skewed and have
+ * long tails, so the summary leans on order statistics: the median, p95
+ * and p99 each come with a distribution free 95% confidence interval
+ * between the order statistics whose ranks the binomial count of samples
+ * below the true quantile falls between, worked out exactly.
+ */
+
+#ifndef BENCHSTATS_H
+#define BENCHSTATS_H
+
+#include <vector>
+
+/******************************************************************************
+ * Quantile: an estimate and its 95% confidence interval. With too few
+ * samples to bound a side at 95%, low is -inf or high is +inf.
+ ******************************************************************************/
+struct Quantile {
+    double value;
+    double low, high;
+};
+
+struct BenchSummary {
+    int count;
+    double mean, stddev;
+    double min, max;
+    Quantile median, p95, p99;
+};
+
+/******************************************************************************
+ * quantile: the p quantile of sorted, interpolated between neighbouring
+ * samples, with its confidence interval.
+ ******************************************************************************/
+Quantile quantile(const std::vector<double> &sorted, double p);
+
+/******************************************************************************
+ * summarize: every statistic of samples, which need not be sorted. All
+ * zero for no samples.
+ ******************************************************************************/
+BenchSummary summarize(std::vector<double> samples);
+
+#endif
@@ -0,0 +1,206 @@
+/*! \file chunk.cxx
+ * Chunk sources and the chunk cache.
+ */
+
+#include <string.h>
+#include "diamondsquare.h"
+#include "midpoint.h"
+#include "perlin.h"
+#include "levels.h"
+#include "chunk.h"
+
+void displaceChunk(HeightmapView chunk, const Rng &rng, int x0, int z0, float disp){
+    const int size = chunk.width;
+    const int last = size - 1;
+    //stream 0 for the corners, then one stream per level keyed by its step
+    const Rng corners = rng.stream(0);
+
+    chunk[0][0] = corners.displacement(disp, x0, z0);
+    chunk[0][last] = corners.displacement(disp, x0 + last, z0);
+    chunk[last][0] = corners.displacement(disp, x0, z0 + last);
+    chunk[last][last] = corners.displacement(disp, x0 + last, z0 + last);
+
+    for (int incr = last; incr > 1; incr /= 2){
+        const int half = incr/2;
+        const Rng level = rng.stream(incr);
+
+        //the border: a one dimensional midpoint pass along each edge, which
+        //reads nothing but that edge
+        for (int k = 0; k < last; k += incr){
+            chunk[0][k+half] = (chunk[0][k] + chunk[0][k+incr])/2
+                             + level.displacement(disp, x0 + k+half, z0);
+            chunk[last][k+half] = (chunk[last][k] + chunk[last][k+incr])/2
+                                + level.displacement(disp, x0 + k+half, z0 + last);
+            chunk[k+half][0] = (chunk[k][0] + chunk[k+incr][0])/2
+                             + level.displacement(disp, x0, z0 + k+half);
+            chunk[k+half][last] = (chunk[k][last] + chunk[k+incr][last])/2
+                                + level.displacement(disp, x0 + last, z0 + k+half);
+        }
+        //diamond step: the centre of every square
+        for (int z = 0; z < last; z += incr){
+            for (int x = 0; x < last; x += incr){
+                chunk[z+half][x+half] = (chunk[z][x] + chunk[z][x+incr]
+                                       + chunk[z+incr][x] + chunk[z+incr][x+incr])/4
+                                      + level.displacement(disp, x0 + x+half, z0 + z+half);
+            }
+        }
+        //square step: the edge midpoints inside the chunk
+        for (int z = half; z < last; z += half){
+            for (int x = (z + half)%incr; x < size; x += incr){
+                if (x == 0 || x == last)
+                    continue;
+                chunk[z][x] = (chunk[z-half][x] + chunk[z+half][x]
+                             + chunk[z][x-half] + chunk[z][x+half])/4
+                            + level.displacement(disp, x0 + x, z0 + z);
+            }
+        }
+        disp *= DISPLACEMENT_DECAY;
+    }
+}
+
+/******************************************************************************
+ * PerlinChunks, DiamondSquareChunks, MidpointChunks: the generators behind
+ * newChunkSource().
+ ******************************************************************************/
+class PerlinChunks : public ChunkSource {
+public:
+    PerlinChunks(int size, uint32_t seed, int octaves) : side(size), seed(seed), octaves(octaves) {}
+    const char *name() const { return "perlin"; }
+    int size() const { return side; }
+    void generate(int cx, int cz, HeightmapView out) const {
+        perlinChunk(out, seed, octaves, cx * (side-1), cz * (side-1));
+    }
+
+private:
+    int side;
+    uint32_t seed;
+    int octaves;
+};
+
+class DiamondSquareChunks : public ChunkSource {
+public:
+    DiamondSquareChunks(int size, uint32_t seed) : side(size), seed(seed) {}
+    const char *name() const { return "diamond"; }
+    int size() const { return side; }
+    void generate(int cx, int cz, HeightmapView out) const {
+        diamondSquareChunk(out, seed, cx * (side-1), cz * (side-1));
+    }
+
+private:
+    int side;
+    uint32_t seed;
+};
+
+class MidpointChunks : public ChunkSource {
+public:
+    MidpointChunks(int size, uint32_t seed) : side(size), seed(seed) {}
+    const char *name() const { return "midpoint"; }
+    int size() const { return side; }
+    void generate(int cx, int cz, HeightmapView out) const {
+        midpointChunk(out, seed, cx * (side-1), cz * (side-1));
+    }
+
+private:
+    int side;
+    uint32_t seed;
+};
+
+ChunkSource *newChunkSource(const char *name, int size, uint32_t seed, int octaves){
+    if (!isPowerOfTwoPlusOne(size))
+        return NULL;
+    if (strcmp(name, "perlin") == 0)
+        return new PerlinChunks(size, seed, octaves);
+    if (strcmp(name, "diamond") == 0)
+        return new DiamondSquareChunks(size, seed);
+    if (strcmp(name, "midpoint") == 0)
+        return new MidpointChunks(size, seed);
+    return NULL;
+}
+
+ChunkCache::ChunkCache(const ChunkSource &source, size_t budget)
+    : src(source), limit(budget), each(chunkBytes(source)), hit(0), miss(0) {}
+
+size_t ChunkCache::chunkBytes(const ChunkSource &source){
+    const int size = source.size();
+    return (size_t)Heightmap::paddedWidth(size) * size * sizeof(float)
+         + sizeof(Heightmap) + sizeof(Entry);
+}
+
+uint64_t ChunkCache::keyOf(int cx, int cz){
+    return (uint64_t)(uint32_t)cx << 32 | (uint32_t)cz;
+}
+
+/******************************************************************************
+ * lookup: the cached chunk for key, moved to the front. Caller holds lock.
+ ******************************************************************************/
+ChunkCache::Chunk ChunkCache::lookup(uint64_t key){
+    auto found = index.find(key);
+    if (found == index.end())
+        return Chunk();
+    order.splice(order.begin(), order, found->second);
+    return found->second->chunk;
+}
+
+/******************************************************************************
+ * evict: drops the least recently used chunks until the rest fit, always
+ * keeping the newest one. Caller holds lock.
+ ******************************************************************************/
+void ChunkCache::evict(){
+    while (order.size() > 1 && order.size() * each > limit){
+        index.erase(order.back().key);
+        order.pop_back();
+    }
+}
+
+ChunkCache::Chunk ChunkCache::get(int cx, int cz){
+    Chunk chunk = find(cx, cz);
+    if (chunk)
+        return chunk;
+    //generate without the lock so other threads keep using the cache
+    std::shared_ptr<Heightmap> fresh = std::make_shared<Heightmap>(src.size());
+    src.generate(cx, cz, fresh->view());
+    return put(cx, cz, fresh);
+}
+
+ChunkCache::Chunk ChunkCache::find(int cx, int cz){
+    std::lock_guard<std::mutex> hold(lock);
+    Chunk chunk = lookup(keyOf(cx, cz));
+    if (chunk)
+        hit++;
+    else
+        miss++;
+    return chunk;
+}
+
+ChunkCache::Chunk ChunkCache::put(int cx, int cz, Chunk chunk){
+    const uint64_t key = keyOf(cx, cz);
+    std::lock_guard<std::mutex> hold(lock);
+    Chunk cached = lookup(key);
+    if (cached)
+        return cached;
+    Entry entry = { key, chunk };
+    order.push_front(entry);
+    index[key] = order.begin();
+    evict();
+    return chunk;
+}
+
+size_t ChunkCache::bytes() const {
+    std::lock_guard<std::mutex> hold(lock);
+    return order.size() * each;
+}
+
+size_t ChunkCache::count() const {
+    std::lock_guard<std::mutex> hold(lock);
+    return order.size();
+}
+
+unsigned long ChunkCache::hits() const {
+    std::lock_guard<std::mutex> hold(lock);
+    return hit;
+}
+
+unsigned long ChunkCache::misses() const {
+    std::lock_guard<std::mutex> hold(lock);
+    return miss;
+}
@@ -0,0 +1,120 @@
+/*! \file chunk.h
+ * Terrain as an unbounded grid of square chunks. Chunk (cx, cz) of a source
+ * with side size covers the world samples x0 .. x0+size-1, z0 .. z0+size-1
+ * with x0 = cx*(size-1), z0 = cz*(size-1): neighbours share their border
+ * row or column and every source writes the same heights there, so chunks
+ * line up without seams.
+ */
+
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "heightmap.h"
+#include "rng.h"
+
+/******************************************************************************
+ * ChunkSource: a generator that fills any chunk on its own. generate() is
+ * const and must be safe to call from several threads at once.
+ ******************************************************************************/
+class ChunkSource {
+public:
+    virtual ~ChunkSource() {}
+    virtual const char *name() const = 0;
+    /**************************************************************************
+     * size: samples per chunk side, 2n+1.
+     **************************************************************************/
+    virtual int size() const = 0;
+    /**************************************************************************
+     * generate: writes chunk (cx, cz) to out, which is size() square.
+     **************************************************************************/
+    virtual void generate(int cx, int cz, HeightmapView out) const = 0;
+};
+
+/******************************************************************************
+ * newChunkSource: "perlin", "diamond" or "midpoint" chunks of side size
+ * (2n+1), NULL for an unknown name or size. octaves is only used by perlin.
+ ******************************************************************************/
+ChunkSource *newChunkSource(const char *name, int size, uint32_t seed, int octaves);
+
+/******************************************************************************
+ * displaceChunk: midpoint displacement for one chunk of side 2n+1 whose
+ * first sample sits at world (x0, z0). The corners and the border are
+ * displaced along the edges alone, keyed by world position, so the chunk
+ * sharing an edge computes the same values; the inside then runs the
+ * diamond and square steps without touching the border. disp is the
+ * displacement range of the first level; every level has 2^-0.55 of the
+ * one before.
+ ******************************************************************************/
+void displaceChunk(HeightmapView chunk, const Rng &rng, int x0, int z0, float disp);
+
+/******************************************************************************
+ * ChunkCache: generated chunks, most recently used first, kept under a
+ * byte budget. get() returns a cached chunk without regenerating it;
+ * generating a new one evicts the least recently used until the rest fit.
+ * A chunk still held by a caller outlives its eviction. Safe to share
+ * between threads.
+ ******************************************************************************/
+class ChunkCache {
+public:
+    typedef std::shared_ptr<const Heightmap> Chunk;
+
+    ChunkCache(const ChunkSource &source, size_t budget);
+    ChunkCache(const ChunkCache &) = delete;
+    ChunkCache &operator=(const ChunkCache &) = delete;
+
+    /**************************************************************************
+     * get: chunk (cx, cz), generated on a miss by the calling thread.
+     **************************************************************************/
+    Chunk get(int cx, int cz);
+
+    /**************************************************************************
+     * find: chunk (cx, cz) if it is cached, else an empty pointer. Counts
+     * as a use but never generates.
+     **************************************************************************/
+    Chunk find(int cx, int cz);
+
+    /**************************************************************************
+     * put: caches a chunk generated elsewhere, e.g. on a worker thread.
+     * Returns the cached copy, which is the older one if two raced.
+     **************************************************************************/
+    Chunk put(int cx, int cz, Chunk chunk);
+
+    const ChunkSource &source() const { return src; }
+    size_t budget() const { return limit; }
+    size_t bytes() const;
+    size_t count() const;
+    unsigned long hits() const;
+    unsigned long misses() const;
+
+    /**************************************************************************
+     * chunkBytes: what one chunk of source counts against the budget.
+     **************************************************************************/
+    static size_t chunkBytes(const ChunkSource &source);
+
+private:
+    struct Entry {
+        uint64_t key;
+        Chunk chunk;
+    };
+    typedef std::list<Entry> Order;
+
+    static uint64_t keyOf(int cx, int cz);
+    Chunk lookup(uint64_t key);
+    void evict();
+
+    const ChunkSource &src;
+    const size_t limit;
+    const size_t each;
+    mutable std::mutex lock;
+    Order order;                                        // front is most recent
+    std::unordered_map<uint64_t, Order::iterator> index;
+    unsigned long hit, miss;
+};
+
+#endif
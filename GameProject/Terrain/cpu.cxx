@@ -0,0 +1,27 @@
+/*! \file cpu.cxx
+ * Run time instruction set checks.
+ */
+
+#include "cpu.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+bool cpuHasSSE(){
+    return __builtin_cpu_supports("sse4.1");
+}
+
+bool cpuHasAVX2(){
+    return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+bool cpuHasSSE(){
+    return false;
+}
+
+bool cpuHasAVX2(){
+    return false;
+}
+
+#endif
@@ -0,0 +1,17 @@
+/*! \file cpu.h
+ * Run time checks for the instruction sets the SIMD kernels are compiled
+ * for. Kernels built with a target attribute must only be called after the
+ * matching check said yes.
+ */
+
+#ifndef CPU_H
+#define CPU_H
+
+/******************************************************************************
+ * cpuHasSSE, cpuHasAVX2: whether SSE4.1 / AVX2 kernels can run on this
+ * machine. Always false off x86, where they are not compiled in.
+ ******************************************************************************/
+bool cpuHasSSE();
+bool cpuHasAVX2();
+
+#endif
@@ -0,0 +1,198 @@
+/*! \file diamondsquare.cxx
+ * Diamond-Square Algorithm: each level sets the centre of every square from its
+ * four corners (diamond step), then the edge midpoints from the surrounding
+ * diamond (square step), halving the displacement as the squares get smaller.
+ */
+
+#include "rng.h"
+#include "chunk.h"
+#include "trace.h"
+#include "levels.h"
+#include "diamondsquare.h"
+
+//levels with fewer rows than this are not worth waking the pool for
+static const int PARALLEL_ROWS = 32;
+
+static constexpr float DISPLACEMENT = 10.0f;    // displacement of the first level
+
+/******************************************************************************
+ * edgeMean: the mean of the four neighbours half away from (r, c), read
+ * through border. A neighbour the policy maps back onto (r, c) itself, as
+ * CLAMP does at every level but the finest, is left out.
+ ******************************************************************************/
+static float edgeMean(HeightmapView diamond, int r, int c, int half, BorderPolicy border){
+    const int size = diamond.width;
+    const int rows[4] = { r, r, r - half, r + half };
+    const int cols[4] = { c - half, c + half, c, c };
+    float total = 0.0f;
+    int count = 0;
+    for (int k = 0; k < 4; k++){
+        int i = borderIndex(rows[k], size, border), j = borderIndex(cols[k], size, border);
+        if (i != r || j != c){
+            total += diamond[i][j];
+            count++;
+        }
+    }
+    return total / count;
+}
+
+/******************************************************************************
+ * squareRow: the square step on row r, whose samples sit every incr
+ * columns. Samples on the edge of the map go through edgeMean; the loop
+ * over the rest reads its neighbours directly.
+ ******************************************************************************/
+template <int SIZE, int INCR>
+static void squareRow(HeightmapView diamond, const Rng &level, int r, int step, float disp,
+                      BorderPolicy border){
+    const int size = fixed<SIZE>(diamond.width), incr = fixed<INCR>(step);
+    const int half = incr/2, last = size - 1;
+    float *row = diamond[r];
+    if (r == 0 || r == last){
+        for (int c = (r + half)%incr; c < size; c += incr)
+            row[c] = edgeMean(diamond, r, c, half, border) + level.displacement(disp, c, r);
+        return;
+    }
+    const float *up = diamond[r - half];
+    const float *down = diamond[r + half];
+    int c = (r + half)%incr;
+    if (c == 0){
+        row[0] = edgeMean(diamond, r, 0, half, border) + level.displacement(disp, 0, r);
+        c += incr;
+    }
+    for (; c < last; c += incr)
+        row[c] = (row[c - half] + row[c + half] + up[c] + down[c]) / 4.0f + level.displacement(disp, c, r);
+    if (c == last)
+        row[last] = edgeMean(diamond, r, last, half, border) + level.displacement(disp, last, r);
+}
+
+/******************************************************************************
+ * diamondColumns: the diamond step on the squares in columns begin .. end
+ * (counted in squares).
+ ******************************************************************************/
+template <int SIZE, int INCR>
+static void diamondColumns(HeightmapView diamond, const Rng &level, int begin, int end, int step,
+                           float disp){
+    TRACE_ZONE("diamond pass");
+    const int size = fixed<SIZE>(diamond.width), incr = fixed<INCR>(step), half = incr/2;
+    for (int i = begin*incr; i < end*incr; i += incr){
+        for (int j = 0; j < size-1; j += incr){
+            //finding the mean of its four corners augmented bi a random num.
+            float t = (diamond[j][i]
+            + diamond[j+incr][i]
+            + diamond[j][i+incr]
+            + diamond[j+incr][i+incr])/4 + level.displacement(disp, i+half, j+half);
+            diamond[j+half][i+half] = t;
+        }
+    }
+}
+
+/******************************************************************************
+ * diamondSquareLevel: the diamond and square passes of the level with the
+ * given step. SIZE and INCR are the grid size and step when they are known
+ * at compile time, 0 when they are not.
+ ******************************************************************************/
+template <int SIZE, int INCR>
+static void diamondSquareLevel(HeightmapView diamond, const Rng &rng, int step, float disp,
+                               ThreadPool *pool, BorderPolicy border){
+    const int size = fixed<SIZE>(diamond.width), incr = fixed<INCR>(step), half = incr/2;
+    //every write in a pass reads only cells of earlier passes, so the
+    //columns of the diamond pass and the rows of the square pass can be
+    //handed out to threads in any order
+    ThreadPool *levelPool = (size-1)/incr >= PARALLEL_ROWS ? pool : NULL;
+    const Rng level = rng.stream(incr);
+
+    parallelFor(levelPool, 0, (size-1)/incr, [&](int begin, int end){
+        diamondColumns<SIZE, INCR>(diamond, level, begin, end, incr, disp);
+    });
+    //square step. involves setting square to the correct offset 
+    parallelFor(levelPool, 0, (size-1)/half + 1, [&](int begin, int end){
+        TRACE_ZONE("square pass");
+        //the square step has always displaced by whole units
+        for (int i = begin*half; i < end*half; i += half)
+            squareRow<SIZE, INCR>(diamond, level, i, incr, (int)disp, border);
+    });
+}
+
+/******************************************************************************
+ * DiamondSquareLevels: the levels from step INCR down, one instantiation
+ * each, so the level loop is unrolled and every stride is a constant.
+ ******************************************************************************/
+template <int SIZE, int INCR>
+struct DiamondSquareLevels {
+    static void run(HeightmapView diamond, const Rng &rng, ThreadPool *pool, BorderPolicy border){
+        constexpr float disp = levelDisplacement(DISPLACEMENT, gridLevels(SIZE) - gridLevels(INCR + 1));
+        diamondSquareLevel<SIZE, INCR>(diamond, rng, INCR, disp, pool, border);
+        DiamondSquareLevels<SIZE, INCR/2>::run(diamond, rng, pool, border);
+    }
+};
+
+template <int SIZE>
+struct DiamondSquareLevels<SIZE, 1> {
+    static void run(HeightmapView, const Rng &, ThreadPool *, BorderPolicy){}
+};
+
+/******************************************************************************
+ * seedCorners: seeds the four corners of diamond from stream 0 of rng.
+ ******************************************************************************/
+static void seedCorners(HeightmapView diamond, const Rng &rng){
+    const int size = diamond.width;
+    const float MIN_Z = -1.0f * (size/2);
+    const Rng corners = rng.stream(0);
+
+    diamond[0][0] = MIN_Z + corners.displacement(2.0f, 0, 0);
+    diamond[0][size-1] = MIN_Z + corners.displacement(2.0f, size-1, 0);
+    diamond[size-1][size-1] = MIN_Z + corners.displacement(2.0f, size-1, size-1);
+    diamond[size-1][0] = MIN_Z + corners.displacement(2.0f, 0, size-1);
+}
+
+template <int SIZE>
+void diamondSquare(HeightmapView diamond, uint32_t seed, ThreadPool *pool, BorderPolicy border) {
+    static_assert(isPowerOfTwoPlusOne(SIZE), "diamondSquare needs a 2n+1 grid");
+    requireGrid("diamondSquare", diamond.width, diamond.height, SIZE);
+    TRACE_ZONE("diamondSquare");
+    //stream 0 for the corners, then one stream per level keyed by its step
+    const Rng rng(seed);
+    seedCorners(diamond, rng);
+    DiamondSquareLevels<SIZE, SIZE - 1>::run(diamond, rng, pool, border);
+}
+
+template void diamondSquare<33>(HeightmapView, uint32_t, ThreadPool *, BorderPolicy);
+template void diamondSquare<65>(HeightmapView, uint32_t, ThreadPool *, BorderPolicy);
+template void diamondSquare<129>(HeightmapView, uint32_t, ThreadPool *, BorderPolicy);
+template void diamondSquare<257>(HeightmapView, uint32_t, ThreadPool *, BorderPolicy);
+template void diamondSquare<513>(HeightmapView, uint32_t, ThreadPool *, BorderPolicy);
+template void diamondSquare<1025>(HeightmapView, uint32_t, ThreadPool *, BorderPolicy);
+template void diamondSquare<2049>(HeightmapView, uint32_t, ThreadPool *, BorderPolicy);
+template void diamondSquare<4097>(HeightmapView, uint32_t, ThreadPool *, BorderPolicy);
+template void diamondSquare<8193>(HeightmapView, uint32_t, ThreadPool *, BorderPolicy);
+
+typedef void (*DiamondSquareFn)(HeightmapView, uint32_t, ThreadPool *, BorderPolicy);
+
+//the instantiations above in sizedIndex() order
+static const DiamondSquareFn SIZED[] = {
+    diamondSquare<33>, diamondSquare<65>, diamondSquare<129>, diamondSquare<257>, diamondSquare<513>,
+    diamondSquare<1025>, diamondSquare<2049>, diamondSquare<4097>, diamondSquare<8193>
+};
+static_assert(sizeof(SIZED)/sizeof(SIZED[0]) == SIZED_COUNT, "one instantiation per sized grid");
+
+void diamondSquare(HeightmapView diamond, uint32_t seed, ThreadPool *pool, BorderPolicy border) {
+    requireGrid("diamondSquare", diamond.width, diamond.height, 0);
+    int k = sizedIndex(diamond.width);
+    if (k >= 0){
+        SIZED[k](diamond, seed, pool, border);
+        return;
+    }
+    TRACE_ZONE("diamondSquare");
+    const Rng rng(seed);
+    seedCorners(diamond, rng);
+
+    float disp = DISPLACEMENT;
+    for (int incr = diamond.width - 1; incr > 1; incr /= 2){
+        diamondSquareLevel<0, 0>(diamond, rng, incr, disp, pool, border);
+        disp *= DISPLACEMENT_DECAY;
+    }
+}
+
+void diamondSquareChunk(HeightmapView chunk, uint32_t seed, int x0, int z0){
+    displaceChunk(chunk, Rng(seed), x0, z0, DISPLACEMENT);
+}
@@ -0,0 +1,40 @@
+/*! \file diamondsquare.h
+ * Diamond-Square Algorithm.
+ */
+
+#ifndef DIAMONDSQUARE_H
+#define DIAMONDSQUARE_H
+
+#include <stdint.h>
+#include "heightmap.h"
+#include "threadpool.h"
+
+/******************************************************************************
+ * diamondSquare: uses the Diamond-Square Algorithm to write heightmap values 
+ * to map. It exits with a message unless map is square with a 2n+1
+ * side. The map depends only on seed: with a pool each level's diamond
+ * and square passes are split across its threads and the result is the
+ * same for any number of threads. border decides what the square step
+ * reads past the edge.
+ ******************************************************************************/
+void diamondSquare(HeightmapView map, uint32_t seed, ThreadPool *pool = NULL,
+                   BorderPolicy border = BORDER_WRAP);
+
+/******************************************************************************
+ * diamondSquare<SIZE>: the same map from code built for a SIZE x SIZE grid,
+ * with the levels unrolled and their strides and displacements constant.
+ * Instantiated for the 2n+1 sizes SIZED_MIN .. SIZED_MAX of levels.h, which
+ * the function above picks for a map of those sizes. Exits if map is not
+ * SIZE x SIZE.
+ ******************************************************************************/
+template <int SIZE>
+void diamondSquare(HeightmapView map, uint32_t seed, ThreadPool *pool = NULL,
+                   BorderPolicy border = BORDER_WRAP);
+
+/******************************************************************************
+ * diamondSquareChunk: one chunk of an unbounded Diamond-Square map whose
+ * first sample sits at world (x0, z0), see displaceChunk() in chunk.h.
+ ******************************************************************************/
+void diamondSquareChunk(HeightmapView chunk, uint32_t seed, int x0, int z0);
+
+#endif
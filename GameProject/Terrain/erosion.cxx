@@ -0,0 +1,387 @@
+/*! \file erosion.cxx
+ * Water Erosion Algorithm.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "erosionrow.h"
+#include "trace.h"
+#include "erosion.h"
+
+const int SPARSE_REFRESH = 32;  // steps between whole map passes of the sparse mode
+const int SPARSE_DENSE = 3;     // sparse mode runs a whole map pass while over 1/3 of the map is active
+const int SPARSE_RECOUNT = 8;   // steps between counts of the active cells while it does
+const int MULTIGRID_MIN = 17;   // smallest side a coarse level may have
+
+//the water rain and evaporation settle a cell that sends and gets nothing to
+const float STILL_WATER = RAIN * (1.0f - EVAPORATION) / EVAPORATION;
+
+/******************************************************************************
+ * Flow: where each cell's water goes during one movement step, zeroed. dir is
+ * (x+1)*3 + (y+1) for the neighbour (m+x, n+y), STAY for none; amount is how
+ * much water leaves the cell. Both carry a ghost ring that never sends
+ * anything, so the drain reads all eight neighbours of every cell without
+ * testing for the edge.
+ ******************************************************************************/
+struct Flow {
+    Heightmap level;        // erosion + water, the surface the water sits on
+    Heightmap amount;
+    std::vector<unsigned char> dir;
+    int size;
+
+    explicit Flow(int size) : level(size), amount(size, size, 1),
+                              dir((size + 2) * (size + 2), STAY), size(size) {}
+    unsigned char *dirRow(int m) { return &dir[(m + 1) * (size + 2) + 1]; }
+};
+
+/******************************************************************************
+ * outflowCell: picks the lowest neighbour of an interior cell n and how much
+ * of its water flows there. level holds the surface rows m-1, m and m+1.
+ ******************************************************************************/
+static inline void outflowCell(const float *const level[3], float water, int n,
+                               unsigned char &dir, float &amount){
+    float curr, diff, max;
+    int low_x = 0, low_y = 0;
+    curr = level[1][n];
+    max = -FLT_MAX;
+    for(int x = -1; x < 2; x += 1){
+        for (int y = -1; y < 2; y += 1){
+            diff = curr - level[x+1][n+y];
+            if(diff > max){
+                max = diff;
+                low_x = x;
+                low_y = y;
+            }
+        }
+    }
+    if (max > 0.0f){
+        dir = (low_x + 1) * 3 + (low_y + 1);
+        amount = water < max ? water : max/2.0f;
+    }
+    else {
+        dir = STAY;
+        amount = 0.0f;
+    }
+}
+
+/******************************************************************************
+ * outflow: outflowCell for every interior cell in rows [first, last). Reads
+ * only flow.level and water, so rows can run in parallel.
+ ******************************************************************************/
+static void outflow(HeightmapView water, Flow &flow, int first, int last){
+    const int size = water.width;
+    //the border never sends water; its amount and dir stay 0 and STAY
+    for(int m = std::max(first, 1); m < std::min(last, size-1); m++){
+        const float *level[3] = { flow.level[m-1], flow.level[m], flow.level[m+1] };
+        const float *w = water[m];
+        float *amount = flow.amount[m];
+        unsigned char *dir = flow.dirRow(m);
+        for(int n = 1; n < (size -1); n++)
+            outflowCell(level, w[n], n, dir[n], amount[n]);
+    }
+}
+
+/******************************************************************************
+ * step: one iteration. rain and dissolve in one sweep, the flow pass, then
+ * the inflow gather, evaporation and deposit in another. No sweep writes
+ * anything another row of the same sweep reads, so rows run in parallel and
+ * the water ping-pongs between water and next.
+ ******************************************************************************/
+static void step(HeightmapView erosion, Heightmap &water, Heightmap &next, Flow &flow,
+                 ThreadPool *pool, RainRow rain, DrainRow drain){
+    const int size = erosion.width;
+    parallelFor(pool, 0, size, [&](int first, int last){
+        TRACE_ZONE("erosion rain");
+        for(int m = first; m < last; m++)
+            rain(erosion[m], water[m], flow.level[m], size);
+    });
+    //simulate water movement due to gravity
+    parallelFor(pool, 0, size, [&](int first, int last){
+        TRACE_ZONE("erosion flow");
+        outflow(water, flow, first, last);
+    });
+    parallelFor(pool, 0, size, [&](int first, int last){
+        TRACE_ZONE("erosion drain");
+        for(int m = first; m < last; m++){
+            DrainRows rows;
+            rows.water = water[m];
+            for(int k = 0; k < 3; k++){
+                rows.amount[k] = flow.amount[m + 1 - k];
+                rows.dir[k] = flow.dirRow(m + 1 - k);
+            }
+            rows.erosion = erosion[m];
+            rows.next = next[m];
+            drain(rows, size);
+        }
+    });
+    std::swap(water, next);
+}
+
+/******************************************************************************
+ * Sparse: the worklist of the sparse mode. Rain and evaporation treat every
+ * cell alike, so they run densely over the map. Only the flow and the
+ * transfer of water between cells are local, and a cell is active while it
+ * sends water, or while its water is more than the tolerance from
+ * STILL_WATER. A cell that is neither sits on flat ground among cells
+ * with the same water, so its neighbours stay level with it and it keeps
+ * sending nothing.
+ ******************************************************************************/
+struct Sparse {
+    struct Cell { int m, n; };
+    //near has a ring of one cell all round, so marking the cells around an
+    //active one needs no edge tests; cell (m, n) is near[(m + 1) * stride + n + 1]
+    std::vector<unsigned char> near;    // on this step's worklist: active or next to an active cell
+    std::vector<int> active;            // near index of the cells active after the last step
+    std::vector<Cell> flowing;          // the cells that send water this step
+    int stride;
+    bool dense;                         // too much of the map is active, step it all
+
+    explicit Sparse(int size) : near((size + 2) * (size + 2), 0), stride(size + 2), dense(true) {}
+    unsigned char *nearRow(int m) { return &near[(m + 1) * stride + 1]; }
+};
+
+/******************************************************************************
+ * isActive: whether a cell with water w and flow direction dir is active.
+ ******************************************************************************/
+static inline bool isActive(float w, unsigned char dir, float tolerance){
+    return dir != STAY || fabsf(w - STILL_WATER) > tolerance;
+}
+
+/******************************************************************************
+ * settle: the cells on the worklist that are active after the step go on
+ * the next one, and the worklist is cleared.
+ ******************************************************************************/
+static void settle(HeightmapView water, Flow &flow, Sparse &sp, float tolerance){
+    const int size = water.width, stride = sp.stride;
+    sp.active.clear();
+    for (int m = 0; m < size; m++){
+        unsigned char *near = sp.nearRow(m);
+        const float *w = water[m];
+        const unsigned char *dir = flow.dirRow(m);
+        for (int n = 0; n < size; n++)
+            if (near[n]){
+                near[n] = 0;
+                if (isActive(w[n], dir[n], tolerance))
+                    sp.active.push_back((m + 1) * stride + n + 1);
+            }
+    }
+    sp.dense = sp.active.size() > (size_t)size * size / SPARSE_DENSE;
+}
+
+/******************************************************************************
+ * countActive: the active cells of the whole map.
+ ******************************************************************************/
+static size_t countActive(HeightmapView water, Flow &flow, float tolerance){
+    const int size = water.width;
+    size_t count = 0;
+    for (int m = 0; m < size; m++){
+        const float *w = water[m];
+        const unsigned char *dir = flow.dirRow(m);
+        for (int n = 0; n < size; n++)
+            count += isActive(w[n], dir[n], tolerance);
+    }
+    return count;
+}
+
+/******************************************************************************
+ * sparseStep: step t of the sparse mode. Rain and evaporation sweep every
+ * row, the flow pass runs on the active cells and the ring around them, and
+ * water moves from just the cells that send it. While more than
+ * 1/SPARSE_DENSE of the map is active the worklist costs more than it
+ * saves, so the step is a dense step() instead; so is every
+ * SPARSE_REFRESH-th, which picks up slopes grown from the water
+ * differences the tolerance let through.
+ ******************************************************************************/
+static void sparseStep(HeightmapView erosion, Heightmap &water, Heightmap &next, Flow &flow,
+                       Sparse &sp, int t, float tolerance, ThreadPool *pool, RainRow rain,
+                       DrainRow drain, EvaporateRow evaporate){
+    TRACE_ZONE("erosion sparse step");
+    const int size = erosion.width, stride = sp.stride;
+    if (t % SPARSE_REFRESH == 0 || sp.dense){
+        step(erosion, water, next, flow, pool, rain, drain);
+        //the worklist is only built once it is small enough to pay off
+        if (t % SPARSE_RECOUNT == SPARSE_RECOUNT - 1)
+            sp.dense = countActive(water, flow, tolerance) > (size_t)size * size / SPARSE_DENSE;
+        if (!sp.dense){
+            std::fill(sp.near.begin(), sp.near.end(), 1);
+            settle(water, flow, sp, tolerance);
+        }
+        return;
+    }
+    for (size_t k = 0; k < sp.active.size(); k++){
+        unsigned char *centre = &sp.near[sp.active[k]];
+        for (int i = -stride; i <= stride; i += stride)
+            centre[i - 1] = centre[i] = centre[i + 1] = 1;
+    }
+    TRACE_COUNTER("erosion active", sp.active.size());
+
+    parallelFor(pool, 0, size, [&](int first, int last){
+        TRACE_ZONE("erosion rain");
+        for(int m = first; m < last; m++)
+            rain(erosion[m], water[m], flow.level[m], size);
+    });
+    //simulate water movement due to gravity. A cell off the worklist sent
+    //nothing last step and its dir is still STAY
+    sp.flowing.clear();
+    for (int m = 1; m < size - 1; m++){
+        const unsigned char *near = sp.nearRow(m);
+        const float *level[3] = { flow.level[m-1], flow.level[m], flow.level[m+1] };
+        const float *w = water[m];
+        float *amount = flow.amount[m];
+        unsigned char *dir = flow.dirRow(m);
+        for (int n = 1; n < size - 1; n++)
+            if (near[n]){
+                outflowCell(level, w[n], n, dir[n], amount[n]);
+                if (dir[n] != STAY){
+                    Sparse::Cell c = { m, n };
+                    sp.flowing.push_back(c);
+                }
+            }
+    }
+    //every amount was worked out from the water before the move, so the
+    //move can run in place
+    for (size_t k = 0; k < sp.flowing.size(); k++){
+        const int m = sp.flowing[k].m, n = sp.flowing[k].n;
+        int d = flow.dirRow(m)[n];
+        float amount = flow.amount[m][n];
+        water[m][n] -= amount;
+        water[m + d / 3 - 1][n + d % 3 - 1] += amount;
+    }
+    parallelFor(pool, 0, size, [&](int first, int last){
+        TRACE_ZONE("erosion evaporate");
+        for(int m = first; m < last; m++)
+            evaporate(erosion[m], water[m], size);
+    });
+
+    settle(water, flow, sp, tolerance);
+}
+
+/******************************************************************************
+ * restrictMap: coarse[i][j] is the [1 2 1] x [1 2 1] / 16 weighted average
+ * of fine around fine[2i][2j], with the border clamped.
+ ******************************************************************************/
+static void restrictMap(HeightmapView fine, HeightmapView coarse, ThreadPool *pool){
+    const int size = fine.width;
+    parallelFor(pool, 0, coarse.height, [&](int first, int last){
+        for (int i = first; i < last; i++)
+            for (int j = 0; j < coarse.width; j++){
+                float sum = 0.0f;
+                for (int di = -1; di < 2; di++)
+                    for (int dj = -1; dj < 2; dj++){
+                        int r = std::min(std::max(2 * i + di, 0), size - 1);
+                        int c = std::min(std::max(2 * j + dj, 0), size - 1);
+                        sum += fine[r][c] * ((2 - abs(di)) * (2 - abs(dj)));
+                    }
+                coarse[i][j] = sum / 16.0f;
+            }
+    });
+}
+
+/******************************************************************************
+ * prolongAdd: adds coarse, bilinearly interpolated, to fine. fine[r][c]
+ * sits at coarse[r/2][c/2]; past the last coarse row or column the edge
+ * value is used.
+ ******************************************************************************/
+static void prolongAdd(HeightmapView coarse, HeightmapView fine, ThreadPool *pool){
+    parallelFor(pool, 0, fine.height, [&](int first, int last){
+        for (int r = first; r < last; r++){
+            const int i0 = r / 2, i1 = std::min(i0 + (r & 1), coarse.height - 1);
+            for (int c = 0; c < fine.width; c++){
+                const int j0 = c / 2, j1 = std::min(j0 + (c & 1), coarse.width - 1);
+                fine[r][c] += 0.25f * (coarse[i0][j0] + coarse[i0][j1] + coarse[i1][j0] + coarse[i1][j1]);
+            }
+        }
+    });
+}
+
+/******************************************************************************
+ * multigrid: erodes a pyramid of ever coarser copies of the map, coarsest
+ * first. Drainage spreads a cell per step at any level, so on a level with
+ * cells twice as wide valleys form in half the steps. Level k (0 the map
+ * itself, up to levels) runs iter / 2^(levels - k + 1) steps and the map
+ * the rest, so every cell still sees iter steps of rain. What a
+ * level eroded is interpolated onto the next finer one before that one
+ * starts.
+ ******************************************************************************/
+static void multigrid(HeightmapView erosion, HeightmapView water, int iter, int most,
+                      ThreadPool *pool){
+    std::vector<Heightmap> pyramid;
+    pyramid.reserve(most);
+    HeightmapView finer = erosion;
+    while ((int)pyramid.size() < most && (finer.width + 1) / 2 >= MULTIGRID_MIN){
+        pyramid.push_back(Heightmap((finer.width + 1) / 2));
+        restrictMap(finer, pyramid.back(), pool);
+        finer = pyramid.back();
+    }
+
+    const int levels = pyramid.size();
+    int left = iter;
+    for (int k = levels; k > 0; k--){
+        HeightmapView level = pyramid[k - 1];
+        HeightmapView above = k > 1 ? HeightmapView(pyramid[k - 2]) : erosion;
+        TRACE_ZONE("erosion multigrid level");
+        TRACE_COUNTER("erosion level size", level.width);
+        Heightmap wet(level.width);
+        int steps = iter >> (levels - k + 1);
+        waterErosion(level, wet, steps, pool);
+        left -= steps;
+
+        //what this level eroded: the level less a fresh restriction of the
+        //untouched finer one
+        Heightmap base(level.width);
+        restrictMap(above, base, pool);
+        for (int r = 0; r < level.height; r++)
+            for (int c = 0; c < level.width; c++)
+                level[r][c] -= base[r][c];
+        prolongAdd(level, above, pool);
+    }
+    waterErosion(erosion, water, left, pool);
+}
+
+void waterErosion(HeightmapView erosion, HeightmapView water, int iter, ThreadPool *pool,
+                  const ErosionParams &params){
+    TRACE_ZONE("waterErosion");
+    if (params.method == EROSION_MULTIGRID){
+        multigrid(erosion, water, iter, params.levels, pool);
+        return;
+    }
+    const int size = erosion.width;
+    //the step ping-pongs between two private buffers and copies back at the end
+    Heightmap current(size), next(size);
+    Flow flow(size);
+    for (int r = 0; r < size; r++)
+        for (int c = 0; c < size; c++)
+            current[r][c] = water[r][c];
+
+    RainRow rain = cpuHasAVX2() ? rainRowAVX2 : rainRowScalar;
+    DrainRow drain = cpuHasAVX2() ? drainRowAVX2 : drainRowScalar;
+    if (params.method == EROSION_SPARSE){
+        EvaporateRow evaporate = cpuHasAVX2() ? evaporateRowAVX2 : evaporateRowScalar;
+        Sparse sparse(size);
+        for(int i = 0; i < iter; i++)
+            sparseStep(erosion, current, next, flow, sparse, i, params.tolerance, pool, rain,
+                       drain, evaporate);
+    }
+    else {
+        for(int i = 0; i < iter; i++)
+            step(erosion, current, next, flow, pool, rain, drain);
+    }
+
+    for (int r = 0; r < size; r++)
+        for (int c = 0; c < size; c++)
+            water[r][c] = current[r][c];
+}
+
+bool erosionMethodByName(const char *name, ErosionMethod &method){
+    static const char *names[] = { "dense", "sparse", "multigrid" };
+    for (int i = 0; i < 3; i++)
+        if (strcmp(name, names[i]) == 0){
+            method = (ErosionMethod)i;
+            return true;
+        }
+    return false;
+}
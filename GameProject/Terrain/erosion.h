@@ -0,0 +1,56 @@
+/*! \file erosion.h
+ * Water Erosion Algorithm.
+ */
+
+#ifndef EROSION_H
+#define EROSION_H
+
+#include "heightmap.h"
+#include "threadpool.h"
+
+/******************************************************************************
+ * ErosionMethod: DENSE runs every step on every cell. SPARSE runs rain and
+ * evaporation on every cell but moves water only around the cells that
+ * send some, or whose water has not yet settled to within a tolerance of
+ * what rain and evaporation alone leave; flat ground drops out. Its cost
+ * follows the wet area rather than the map, and its map moves away from
+ * DENSE as the tolerance grows. MULTIGRID runs most of the
+ * steps on 2x, 4x, ... coarser copies of the map, where drainage forms in
+ * fewer steps, and only the rest on the map itself; more levels are faster
+ * and further from DENSE.
+ ******************************************************************************/
+enum ErosionMethod {
+    EROSION_DENSE,
+    EROSION_SPARSE,
+    EROSION_MULTIGRID
+};
+
+/******************************************************************************
+ * ErosionParams: the method and its knobs.
+ ******************************************************************************/
+struct ErosionParams {
+    ErosionMethod method;
+    float tolerance;        // SPARSE: distance from settled water that keeps a cell active
+    int levels;             // MULTIGRID: coarse levels under the map, each half as wide
+};
+
+const ErosionParams EROSION_DEFAULTS = { EROSION_DENSE, 1e-5f, 2 };
+
+/******************************************************************************
+ * waterErosion: emulates the steps of natural erosion
+ * rainfall, erosion, movement. water holds the standing water per cell and
+ * must start zeroed. The movement step reads one water buffer and writes
+ * another, so DENSE splits across pool and the map is the same for any
+ * number of threads, as does MULTIGRID. SPARSE splits its rain and
+ * evaporation sweeps across pool and moves water on the calling thread.
+ ******************************************************************************/
+void waterErosion(HeightmapView erosion, HeightmapView water, int iter, ThreadPool *pool = NULL,
+                  const ErosionParams &params = EROSION_DEFAULTS);
+
+/******************************************************************************
+ * erosionMethodByName: "dense", "sparse" or "multigrid" for --method. False for anything
+ * else.
+ ******************************************************************************/
+bool erosionMethodByName(const char *name, ErosionMethod &method);
+
+#endif
@@ -0,0 +1,135 @@
+/*! \file erosionrow.cxx
+ * Row kernels for Water Erosion: AVX2 does 8 cells per step and performs the
+ * same float operations in the same order as the scalar kernels, so the map
+ * does not depend on which one ran.
+ *
+ * The AVX2 kernels are compiled with a target attribute and only called
+ * after cpuHasAVX2 said yes, so the rest of the library still builds for
+ * the baseline CPU.
+ */
+
+#include "erosionrow.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+void rainRowScalar(float *erosion, float *water, float *level, int count){
+    for (int n = 0; n < count; n++){
+        water[n] += RAIN;
+        erosion[n] -= water[n] * SOLUBILITY;
+        level[n] = erosion[n] + water[n];
+    }
+}
+
+void drainRowScalar(const DrainRows &rows, int count){
+    float *w = rows.next;
+    for (int n = 0; n < count; n++)
+        w[n] = rows.water[n] - rows.amount[1][n];
+    for (int x = -1; x < 2; x++){
+        //row m - x sends to row m along directions (x, y)
+        const float *from = rows.amount[x + 1];
+        const unsigned char *dir = rows.dir[x + 1];
+        for (int y = -1; y < 2; y++){
+            if (!x && !y)
+                continue;
+            const unsigned char code = (x + 1) * 3 + (y + 1);
+            for (int n = 0; n < count; n++)
+                w[n] += dir[n - y] == code ? from[n - y] : 0.0f;
+        }
+    }
+    evaporateRowScalar(rows.erosion, w, count);
+}
+
+void evaporateRowScalar(float *erosion, float *water, int count){
+    for (int n = 0; n < count; n++){
+        float water_lost = water[n] * EVAPORATION;
+        water[n] -= water_lost;
+        erosion[n] += water_lost * SOLUBILITY;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2")))
+void rainRowAVX2(float *erosion, float *water, float *level, int count){
+    const __m256 rain = _mm256_set1_ps(RAIN);
+    const __m256 soluble = _mm256_set1_ps(SOLUBILITY);
+    int n = 0;
+    for (; n + 8 <= count; n += 8){
+        __m256 w = _mm256_add_ps(_mm256_loadu_ps(water + n), rain);
+        __m256 e = _mm256_sub_ps(_mm256_loadu_ps(erosion + n), _mm256_mul_ps(w, soluble));
+        _mm256_storeu_ps(water + n, w);
+        _mm256_storeu_ps(erosion + n, e);
+        _mm256_storeu_ps(level + n, _mm256_add_ps(e, w));
+    }
+    rainRowScalar(erosion + n, water + n, level + n, count - n);
+}
+
+/******************************************************************************
+ * drainRowAVX2: the direction bytes are widened to 32 bits and compared
+ * against the wanted code; the mask zeroes the lanes that do not flow here.
+ ******************************************************************************/
+__attribute__((target("avx2")))
+void drainRowAVX2(const DrainRows &rows, int count){
+    float *w = rows.next;
+    int n = 0;
+    for (; n + 8 <= count; n += 8)
+        _mm256_storeu_ps(w + n, _mm256_sub_ps(_mm256_loadu_ps(rows.water + n),
+                                              _mm256_loadu_ps(rows.amount[1] + n)));
+    for (; n < count; n++)
+        w[n] = rows.water[n] - rows.amount[1][n];
+
+    for (int x = -1; x < 2; x++){
+        const float *from = rows.amount[x + 1];
+        const unsigned char *dir = rows.dir[x + 1];
+        for (int y = -1; y < 2; y++){
+            if (!x && !y)
+                continue;
+            const unsigned char code = (x + 1) * 3 + (y + 1);
+            const __m256i want = _mm256_set1_epi32(code);
+            n = 0;
+            for (; n + 8 <= count; n += 8){
+                __m256i d = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(dir + n - y)));
+                __m256 in = _mm256_and_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(d, want)),
+                                          _mm256_loadu_ps(from + n - y));
+                _mm256_storeu_ps(w + n, _mm256_add_ps(_mm256_loadu_ps(w + n), in));
+            }
+            for (; n < count; n++)
+                w[n] += dir[n - y] == code ? from[n - y] : 0.0f;
+        }
+    }
+
+    evaporateRowAVX2(rows.erosion, w, count);
+}
+
+__attribute__((target("avx2")))
+void evaporateRowAVX2(float *erosion, float *water, int count){
+    const __m256 evaporation = _mm256_set1_ps(EVAPORATION);
+    const __m256 soluble = _mm256_set1_ps(SOLUBILITY);
+    int n = 0;
+    for (; n + 8 <= count; n += 8){
+        __m256 v = _mm256_loadu_ps(water + n);
+        __m256 water_lost = _mm256_mul_ps(v, evaporation);
+        _mm256_storeu_ps(water + n, _mm256_sub_ps(v, water_lost));
+        _mm256_storeu_ps(erosion + n, _mm256_add_ps(_mm256_loadu_ps(erosion + n),
+                                                    _mm256_mul_ps(water_lost, soluble)));
+    }
+    evaporateRowScalar(erosion + n, water + n, count - n);
+}
+
+#else
+
+void rainRowAVX2(float *erosion, float *water, float *level, int count){
+    rainRowScalar(erosion, water, level, count);
+}
+
+void drainRowAVX2(const DrainRows &rows, int count){
+    drainRowScalar(rows, count);
+}
+
+void evaporateRowAVX2(float *erosion, float *water, int count){
+    evaporateRowScalar(erosion, water, count);
+}
+
+#endif
@@ -0,0 +1,59 @@
+/*! \file erosionrow.h
+ * Row kernels behind waterErosion(). Each step is two element-wise sweeps
+ * around the flow pass: rain fuses rainfall, dissolving and the surface
+ * height, drain fuses the inflow gather with evaporation and deposit, so
+ * every row is read and written once per sweep. The AVX2 versions live in
+ * erosionrow.cxx and match the scalar ones bit for bit.
+ */
+
+#ifndef EROSIONROW_H
+#define EROSIONROW_H
+
+#include "cpu.h"
+
+const float RAIN = 0.01f;           // water added to every cell per step
+const float SOLUBILITY = 0.01f;     // height dissolved (and deposited) per unit of water
+const float EVAPORATION = 0.9f;     // fraction of the water lost per step
+
+const unsigned char STAY = 4;       // flow direction of a cell that keeps its water
+
+/******************************************************************************
+ * DrainRows: what drain needs for row m. A neighbour (m+dm, n+dn) sends its
+ * amount to (m, n) when its direction is (-dm, -dn), encoded as
+ * (x+1)*3 + (y+1) like the flow pass does. The rows are readable one cell
+ * past either end, and off the map they are a halo that sends nothing.
+ ******************************************************************************/
+struct DrainRows {
+    const float *water;             // row m before the step
+    const float *amount[3];         // outflow of rows m+1, m, m-1
+    const unsigned char *dir[3];    // their directions
+    float *erosion;                 // row m, gets the deposit
+    float *next;                    // row m after the step
+};
+
+typedef void (*RainRow)(float *erosion, float *water, float *level, int count);
+typedef void (*DrainRow)(const DrainRows &rows, int count);
+typedef void (*EvaporateRow)(float *erosion, float *water, int count);
+
+/******************************************************************************
+ * rainRow: water += RAIN, erosion -= water * SOLUBILITY, level = erosion +
+ * water.
+ ******************************************************************************/
+void rainRowScalar(float *erosion, float *water, float *level, int count);
+void rainRowAVX2(float *erosion, float *water, float *level, int count);
+
+/******************************************************************************
+ * drainRow: next = water - own outflow + inflows, then EVAPORATION of next
+ * is lost and SOLUBILITY of the loss deposited on erosion.
+ ******************************************************************************/
+void drainRowScalar(const DrainRows &rows, int count);
+void drainRowAVX2(const DrainRows &rows, int count);
+
+/******************************************************************************
+ * evaporateRow: the end of drainRow on its own, in place: EVAPORATION of
+ * water is lost and SOLUBILITY of the loss deposited on erosion.
+ ******************************************************************************/
+void evaporateRowScalar(float *erosion, float *water, int count);
+void evaporateRowAVX2(float *erosion, float *water, int count);
+
+#endif
@@ -0,0 +1,244 @@
+/*! \file fault.cxx
+ * Fault-Line Algorithm.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "rng.h"
+#include "cpu.h"
+#include "trace.h"
+#include "fault.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+const int FAULT_TILE = 64;     // 64x64 floats, 16KB, stays in L1 while every line is applied
+
+/******************************************************************************
+ * FaultLine: the line ax + bz + c = 0 relative to the centre of the map.
+ * Cells where the left hand side is positive are raised, the rest lowered.
+ ******************************************************************************/
+struct FaultLine {
+    float a, b, c;
+};
+
+/******************************************************************************
+ * faultLine: draws line i from the lines stream.
+ ******************************************************************************/
+static FaultLine faultLine(const Rng &lines, int i, int size){
+    FaultLine f;
+    f.a = cos(lines.displacement(100.0f, i, 0));
+    f.b = sin(lines.displacement(100.0f, i, 1));
+    f.c = lines.uniform(i, 2) * 2 * sqrt(pow(size, 2)/2)  - sqrt(pow(size, 2)/2);
+    return f;
+}
+
+/******************************************************************************
+ * above: the half-plane test for cell (r, t). Every path uses this exact
+ * expression so they agree on which side a cell is.
+ ******************************************************************************/
+static inline bool above(const FaultLine &f, int r, int t, int half){
+    return (r - half) * f.a + (t - half) * f.b + f.c > 0;
+}
+
+/******************************************************************************
+ * raisedSpan: the columns [lo, hi) of row r that line f raises. Along a row
+ * the test is linear in t so it changes sign at most once; the crossing is
+ * solved for and then nudged until it agrees with above() on both sides.
+ ******************************************************************************/
+static void raisedSpan(const FaultLine &f, int r, int size, int &lo, int &hi){
+    const int half = size/2;
+    if (f.b == 0.0f){
+        lo = 0;
+        hi = above(f, r, 0, half) ? size : 0;
+        return;
+    }
+    //first column past the crossing, clamped before it is made an int
+    float cross = half - ((r - half) * f.a + f.c) / f.b;
+    int t = cross < 0.0f ? 0 : cross > size ? size : (int)ceil(cross);
+    if (f.b > 0.0f){
+        //raised from the crossing to the right edge
+        while (t > 0 && above(f, r, t - 1, half))
+            t--;
+        while (t < size && !above(f, r, t, half))
+            t++;
+        lo = t;
+        hi = size;
+    }
+    else {
+        //raised from the left edge up to the crossing
+        while (t > 0 && !above(f, r, t - 1, half))
+            t--;
+        while (t < size && above(f, r, t, half))
+            t++;
+        lo = 0;
+        hi = t;
+    }
+}
+
+/******************************************************************************
+ * faultRows: for every row, marks each line's raised span in a difference
+ * array and resolves them with one prefix sum: iterations span computations
+ * per row instead of iterations tests per cell.
+ ******************************************************************************/
+static void faultRows(HeightmapView fault, const std::vector<FaultLine> &lines, float disp,
+                      ThreadPool *pool){
+    const int size = fault.width;
+    const int count = lines.size();
+    parallelFor(pool, 0, size, [&](int first, int last){
+        TRACE_ZONE("fault rows");
+        std::vector<int> raised(size + 1);
+        int lo, hi;
+        for (int r = first; r < last; r++){
+            std::fill(raised.begin(), raised.end(), 0);
+            for (int i = 0; i < count; i++){
+                raisedSpan(lines[i], r, size, lo, hi);
+                raised[lo]++;
+                raised[hi]--;
+            }
+            //a cell raised k times was lowered count - k times
+            int k = 0;
+            float *row = fault[r];
+            for (int t = 0; t < size; t++){
+                k += raised[t];
+                row[t] += disp * (2 * k - count);
+            }
+        }
+    });
+}
+
+/******************************************************************************
+ * faultSpanScalar: adds +-disp for line f to columns t0 .. t1-1 of row r.
+ * Written without a branch so the compiler can vectorize it where it may.
+ ******************************************************************************/
+static void faultSpanScalar(const FaultLine &f, int r, int t0, int t1, int half,
+                            float disp, float *row){
+    for (int t = t0; t < t1; t++)
+        row[t] += above(f, r, t, half) ? disp : -disp;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/******************************************************************************
+ * faultSpanAVX2: faultSpanScalar 8 columns at a time. The products and sums
+ * are done in the same order as above(), so the sign of every cell matches.
+ ******************************************************************************/
+__attribute__((target("avx2")))
+static void faultSpanAVX2(const FaultLine &f, int r, int t0, int t1, int half,
+                          float disp, float *row){
+    const __m256 rowTerm = _mm256_set1_ps((r - half) * f.a);
+    const __m256 b = _mm256_set1_ps(f.b);
+    const __m256 c = _mm256_set1_ps(f.c);
+    const __m256 up = _mm256_set1_ps(disp);
+    const __m256 down = _mm256_set1_ps(-disp);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    int t = t0;
+    for (; t + 8 <= t1; t += 8){
+        __m256i col = _mm256_add_epi32(_mm256_set1_epi32(t - half), lanes);
+        __m256 side = _mm256_add_ps(_mm256_add_ps(rowTerm,
+                                    _mm256_mul_ps(_mm256_cvtepi32_ps(col), b)), c);
+        __m256 raise = _mm256_cmp_ps(side, _mm256_setzero_ps(), _CMP_GT_OQ);
+        __m256 h = _mm256_loadu_ps(row + t);
+        _mm256_storeu_ps(row + t, _mm256_add_ps(h, _mm256_blendv_ps(down, up, raise)));
+    }
+    faultSpanScalar(f, r, t, t1, half, disp, row);
+}
+
+#else
+
+static void faultSpanAVX2(const FaultLine &f, int r, int t0, int t1, int half,
+                          float disp, float *row){
+    faultSpanScalar(f, r, t0, t1, half, disp, row);
+}
+
+#endif
+
+/******************************************************************************
+ * faultTiled: the brute force test, tile by tile. Every line is applied to
+ * a FAULT_TILE square while it is in cache instead of streaming the whole map
+ * once per line. Tiles do not overlap, so each thread owns the cells it adds
+ * to, and each cell still sees the lines in order: the result is the same as
+ * faultBrute() bit for bit.
+ ******************************************************************************/
+static void faultTiled(HeightmapView fault, const std::vector<FaultLine> &lines, float disp,
+                       ThreadPool *pool){
+    const int size = fault.width;
+    const int half = size/2;
+    const int count = lines.size();
+    const int tiles = (size + FAULT_TILE - 1) / FAULT_TILE;
+    void (*span)(const FaultLine &, int, int, int, int, float, float *) =
+        cpuHasAVX2() ? faultSpanAVX2 : faultSpanScalar;
+    parallelFor(pool, 0, tiles * tiles, [&](int first, int last){
+        TRACE_ZONE("fault tiles");
+        for (int k = first; k < last; k++){
+            int r0 = (k / tiles) * FAULT_TILE;
+            int t0 = (k % tiles) * FAULT_TILE;
+            int r1 = std::min(r0 + FAULT_TILE, size);
+            int t1 = std::min(t0 + FAULT_TILE, size);
+            for (int i = 0; i < count; i++)
+                for (int r = r0; r < r1; r++)
+                    span(lines[i], r, t0, t1, half, disp, fault[r]);
+        }
+    });
+}
+
+/******************************************************************************
+ * faultBrute: the original loop, every line tested against every cell.
+ ******************************************************************************/
+static void faultBrute(HeightmapView fault, const std::vector<FaultLine> &lines, float disp){
+    const int size = fault.width;
+    const int half = size/2;
+    float aux;
+    for (size_t i = 0; i < lines.size(); i++){
+        for (int r = 0; r < size; r++){
+            for (int t = 0; t < size; t++){
+                if (above(lines[i], r, t, half))
+                    aux = disp;
+                else
+                    aux = -disp;
+                fault[r][t] += aux;
+            }
+        }
+    }
+}
+
+void faultLines(HeightmapView fault, uint32_t seed, int iterations, FaultMethod method,
+                ThreadPool *pool) {
+    TRACE_ZONE("faultLines");
+    const int size = fault.width;
+    const float MIN_Z = -1.0f * (size/2);
+    //stream 0 for the corners, stream 1 for the lines: line i uses counters (i, 0..2)
+    const Rng rng(seed);
+    const Rng corners = rng.stream(0);
+    const Rng stream = rng.stream(1);
+
+    fault[0][0] = MIN_Z + corners.displacement(2.0f, 0, 0);
+    fault[0][size-1] = MIN_Z + corners.displacement(2.0f, size-1, 0);
+    fault[size-1][size-1] = MIN_Z + corners.displacement(2.0f, size-1, size-1);
+    fault[size-1][0] = MIN_Z + corners.displacement(2.0f, 0, size-1);
+
+    std::vector<FaultLine> lines(iterations);
+    for (int i = 0; i < iterations; i++)
+        lines[i] = faultLine(stream, i, size);
+
+    float disp = 0.1f;
+    if (method == FAULT_BRUTE)
+        faultBrute(fault, lines, disp);
+    else if (method == FAULT_TILED)
+        faultTiled(fault, lines, disp, pool);
+    else
+        faultRows(fault, lines, disp, pool);
+}
+
+bool faultMethodByName(const char *name, FaultMethod &method){
+    static const char *names[] = { "rows", "brute", "tiled" };
+    for (int i = 0; i < 3; i++)
+        if (strcmp(name, names[i]) == 0){
+            method = (FaultMethod)i;
+            return true;
+        }
+    return false;
+}
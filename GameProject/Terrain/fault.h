@@ -0,0 +1,39 @@
+/*! \file fault.h
+ * Fault-Line Algorithm.
+ */
+
+#ifndef FAULT_H
+#define FAULT_H
+
+#include <stdint.h>
+#include "heightmap.h"
+#include "threadpool.h"
+
+/******************************************************************************
+ * FaultMethod: how faultLines() applies the lines. All of them raise and
+ * lower the same cells; ROWS sums the displacements exactly where BRUTE and
+ * TILED add them one line at a time, so the heights differ in the last bits.
+ ******************************************************************************/
+enum FaultMethod {
+    FAULT_ROWS,     // per row difference array, O(iterations * size)
+    FAULT_BRUTE,    // every line against every cell, O(iterations * size^2)
+    FAULT_TILED     // BRUTE a cache sized tile at a time, SIMD, same result
+};
+
+/******************************************************************************
+ * faultLines: uses the Fault-Line Algorithm to write heightmap values to 
+ * map. Each of the iterations cuts the map with a random line, raising one
+ * side and lowering the other. The map depends only on seed: ROWS and TILED
+ * split the map across pool and give the same result for any number of
+ * threads. Shared by the Fault and Water Erosion programs.
+ ******************************************************************************/
+void faultLines(HeightmapView map, uint32_t seed, int iterations,
+                FaultMethod method = FAULT_ROWS, ThreadPool *pool = NULL);
+
+/******************************************************************************
+ * faultMethodByName: "rows", "brute" or "tiled" for --method. False for
+ * anything else.
+ ******************************************************************************/
+bool faultMethodByName(const char *name, FaultMethod &method);
+
+#endif
@@ -0,0 +1,27 @@
+/*! \file generate.cxx
+ * Whole map generators picked by name.
+ */
+
+#include <string.h>
+#include "diamondsquare.h"
+#include "midpoint.h"
+#include "fault.h"
+#include "particle.h"
+#include "perlin.h"
+#include "generate.h"
+
+bool generateByName(const char *name, HeightmapView map, const Options &opts, ThreadPool *pool){
+    if (strcmp(name, "diamond") == 0)
+        diamondSquare(map, opts.seed, pool, opts.border);
+    else if (strcmp(name, "midpoint") == 0)
+        midpointDisplacement(map, opts.seed, opts.border);
+    else if (strcmp(name, "fault") == 0)
+        faultLines(map, opts.seed, opts.iterations, FAULT_ROWS, pool);
+    else if (strcmp(name, "particle") == 0)
+        particleDeposition(map, opts.seed, opts.iterations, PARTICLE_SINGLE, pool);
+    else if (strcmp(name, "perlin") == 0)
+        perlinNoise(map, opts.seed, 16);
+    else
+        return false;
+    return true;
+}
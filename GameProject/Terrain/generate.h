@@ -0,0 +1,22 @@
+/*! \file generate.h
+ * Whole map generators picked by name, for the batch programs whose
+ * --method chooses the terrain they work on.
+ */
+
+#ifndef GENERATE_H
+#define GENERATE_H
+
+#include "heightmap.h"
+#include "options.h"
+#include "threadpool.h"
+
+/******************************************************************************
+ * generateByName: fills map with the generator called name: "diamond",
+ * "midpoint", "fault", "particle" or "perlin", seeded and sized by opts.
+ * fault and particle take opts.iterations lines or particles, perlin 16
+ * octaves. False for any other name.
+ ******************************************************************************/
+bool generateByName(const char *name, HeightmapView map, const Options &opts,
+                    ThreadPool *pool = NULL);
+
+#endif
@@ -0,0 +1,132 @@
+/*! \file heightmap.cxx
+ * Aligned, row padded heightmap storage.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "heightmap.h"
+
+Heightmap::Heightmap() : block(NULL), data(NULL), w(0), h(0), s(0), g(0) {}
+
+Heightmap::Heightmap(int width, int height, int halo) : block(NULL), data(NULL), w(0), h(0), s(0), g(0) {
+    allocate(width, height, halo);
+}
+
+Heightmap::Heightmap(int size) : block(NULL), data(NULL), w(0), h(0), s(0), g(0) {
+    allocate(size, size);
+}
+
+Heightmap::Heightmap(Heightmap &&other)
+    : block(other.block), data(other.data), w(other.w), h(other.h), s(other.s), g(other.g) {
+    other.block = other.data = NULL;
+    other.w = other.h = other.s = other.g = 0;
+}
+
+Heightmap &Heightmap::operator=(Heightmap &&other){
+    if (this != &other){
+        release();
+        block = other.block;
+        data = other.data;
+        w = other.w;
+        h = other.h;
+        s = other.s;
+        g = other.g;
+        other.block = other.data = NULL;
+        other.w = other.h = other.s = other.g = 0;
+    }
+    return *this;
+}
+
+Heightmap::~Heightmap(){
+    release();
+}
+
+int Heightmap::paddedWidth(int width){
+    return (width + HEIGHTMAP_LANES - 1) / HEIGHTMAP_LANES * HEIGHTMAP_LANES;
+}
+
+/******************************************************************************
+ * allocate: with a halo every row starts with a whole padded chunk, the
+ * left ghost cells at its end, so cell (r, 0) stays on a cache line.
+ ******************************************************************************/
+void Heightmap::allocate(int width, int height, int halo){
+    release();
+    if (halo < 0 || halo > HEIGHTMAP_HALO_MAX){
+        fprintf(stderr, "a heightmap halo must be 0 to %d cells, not %d\n", HEIGHTMAP_HALO_MAX, halo);
+        exit(1);
+    }
+    int lead = halo > 0 ? HEIGHTMAP_LANES : 0;
+    int stride = lead + paddedWidth(width + halo);
+    size_t bytes = (size_t)stride * (height + 2 * halo) * sizeof(float);
+    void *memory = NULL;
+    if (posix_memalign(&memory, HEIGHTMAP_ALIGN, bytes) != 0){
+        fprintf(stderr, "out of memory for a %d x %d heightmap\n", width, height);
+        exit(1);
+    }
+    block = (float *)memory;
+    data = block + (size_t)halo * stride + lead;
+    w = width;
+    h = height;
+    s = stride;
+    g = halo;
+    memset(block, 0, bytes);
+}
+
+void Heightmap::fill(float value){
+    size_t n = (size_t)s * (h + 2 * g);
+    for (size_t i = 0; i < n; i++)
+        block[i] = value;
+}
+
+void Heightmap::release(){
+    free(block);
+    block = data = NULL;
+    w = h = s = g = 0;
+}
+
+void fillHalo(HeightmapView map, BorderPolicy policy){
+    const int g = map.halo;
+    if (g == 0)
+        return;
+    for (int r = 0; r < map.height; r++){
+        float *row = map[r];
+        for (int k = 1; k <= g; k++){
+            row[-k] = row[borderIndex(-k, map.width, policy)];
+            row[map.width - 1 + k] = row[borderIndex(map.width - 1 + k, map.width, policy)];
+        }
+    }
+    //whole ghost rows, their ghost columns included
+    for (int k = 1; k <= g; k++){
+        memcpy(map[-k] - g, map[borderIndex(-k, map.height, policy)] - g, (map.width + 2 * g) * sizeof(float));
+        memcpy(map[map.height - 1 + k] - g, map[borderIndex(map.height - 1 + k, map.height, policy)] - g,
+               (map.width + 2 * g) * sizeof(float));
+    }
+}
+
+static const char *BORDER_NAMES[] = { "wrap", "clamp", "mirror" };
+
+bool borderPolicyByName(const char *name, BorderPolicy &policy){
+    for (int i = 0; i < 3; i++)
+        if (strcmp(name, BORDER_NAMES[i]) == 0){
+            policy = (BorderPolicy)i;
+            return true;
+        }
+    return false;
+}
+
+const char *borderPolicyName(BorderPolicy policy){
+    return BORDER_NAMES[policy];
+}
+
+bool writeHeightmap(const char *path, HeightmapView map){
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL)
+        return false;
+    bool ok = true;
+    for (int i = 0; i < map.height && ok; i++)
+        ok = fwrite(map.row(i), sizeof(float), map.width, fp) == (size_t)map.width;
+    if (fclose(fp) != 0)
+        ok = false;
+    return ok;
+}
@@ -0,0 +1,154 @@
+/*! \file heightmap.h
+ * Heightmap storage shared by every generator. The map is allocated at run
+ * time as one 64 byte aligned block; each row is padded to a whole number of
+ * SIMD registers so every row starts on a cache line and vector loops never
+ * straddle two rows. map[row][col] indexing works as it did with the old
+ * fixed size arrays.
+ *
+ * A map may also carry a halo of ghost cells on every side, so map[-1][c]
+ * and map[r][width] are valid. fillHalo() copies the border in under a
+ * BorderPolicy before a stencil pass, and the pass then reads its
+ * neighbours without testing for the edge.
+ */
+
+#ifndef HEIGHTMAP_H
+#define HEIGHTMAP_H
+
+#include <stddef.h>
+
+const int HEIGHTMAP_ALIGN = 64;     // bytes, one cache line
+const int HEIGHTMAP_LANES = 16;     // floats per padded row chunk (AVX-512)
+const int HEIGHTMAP_HALO_MAX = HEIGHTMAP_LANES;   // widest halo allocate() takes
+
+/******************************************************************************
+ * BorderPolicy: what lies past the edge of a map. WRAP treats the first and
+ * last sample of a row as the same seam, the way the 2^n+1 generators tile,
+ * so index -1 reads n-2. CLAMP repeats the edge sample and MIRROR reflects
+ * about it, -1 reading 1.
+ ******************************************************************************/
+enum BorderPolicy { BORDER_WRAP, BORDER_CLAMP, BORDER_MIRROR };
+
+/******************************************************************************
+ * borderIndex: the index in [0, n) that i, at most n-2 outside it, reads
+ * under policy.
+ ******************************************************************************/
+inline int borderIndex(int i, int n, BorderPolicy policy){
+    if (i >= 0 && i < n)
+        return i;
+    switch (policy){
+        case BORDER_WRAP:
+            return i < 0 ? i + (n - 1) : i - (n - 1);
+        case BORDER_CLAMP:
+            return i < 0 ? 0 : n - 1;
+        default:
+            return i < 0 ? -i : 2 * (n - 1) - i;
+    }
+}
+
+/******************************************************************************
+ * borderPolicyByName: "wrap", "clamp" or "mirror" for --border. False for
+ * anything else.
+ ******************************************************************************/
+bool borderPolicyByName(const char *name, BorderPolicy &policy);
+
+/******************************************************************************
+ * borderPolicyName: the name borderPolicyByName() takes for policy.
+ ******************************************************************************/
+const char *borderPolicyName(BorderPolicy policy);
+
+class Heightmap;
+
+/******************************************************************************
+ * HeightmapView: non-owning window onto a heightmap, or any part of one.
+ * stride is the distance between rows in floats and may exceed width. halo
+ * is how many ghost cells lie readable on every side.
+ ******************************************************************************/
+struct HeightmapView {
+    float *data;
+    int width;
+    int height;
+    int stride;
+    int halo;
+
+    HeightmapView() : data(NULL), width(0), height(0), stride(0), halo(0) {}
+    HeightmapView(float *d, int w, int h, int s, int g = 0) : data(d), width(w), height(h), stride(s), halo(g) {}
+    HeightmapView(Heightmap &map);
+
+    float *row(int r) const { return data + (ptrdiff_t)r * stride; }
+    float *operator[](int r) const { return row(r); }
+
+    /**************************************************************************
+     * sub: the w x h block whose top left corner is (r, c), without a
+     * halo of its own.
+     **************************************************************************/
+    HeightmapView sub(int r, int c, int w, int h) const {
+        return HeightmapView(row(r) + c, w, h, stride);
+    }
+};
+
+class Heightmap {
+public:
+    Heightmap();
+    Heightmap(int width, int height, int halo = 0);
+    explicit Heightmap(int size);
+    Heightmap(Heightmap &&other);
+    Heightmap &operator=(Heightmap &&other);
+    Heightmap(const Heightmap &) = delete;
+    Heightmap &operator=(const Heightmap &) = delete;
+    ~Heightmap();
+
+    /**************************************************************************
+     * allocate: (re)allocates width x height zeroed floats with halo ghost
+     * cells, at most HEIGHTMAP_HALO_MAX, on every side. Old data is lost.
+     **************************************************************************/
+    void allocate(int width, int height, int halo = 0);
+
+    /**************************************************************************
+     * fill: sets every cell, padding and halo included, to value.
+     **************************************************************************/
+    void fill(float value);
+
+    int width() const { return w; }
+    int height() const { return h; }
+    int stride() const { return s; }
+    int halo() const { return g; }
+    bool empty() const { return data == NULL; }
+
+    float *row(int r) { return data + (ptrdiff_t)r * s; }
+    const float *row(int r) const { return data + (ptrdiff_t)r * s; }
+    float *operator[](int r) { return row(r); }
+    const float *operator[](int r) const { return row(r); }
+
+    HeightmapView view() { return HeightmapView(data, w, h, s, g); }
+
+    /**************************************************************************
+     * paddedWidth: the row stride allocate() uses for a given width and no
+     * halo.
+     **************************************************************************/
+    static int paddedWidth(int width);
+
+private:
+    void release();
+
+    float *block;           // the allocation, halo included
+    float *data;            // cell (0, 0)
+    int w, h, s, g;
+};
+
+inline HeightmapView::HeightmapView(Heightmap &map)
+    : data(map.row(0)), width(map.width()), height(map.height()), stride(map.stride()),
+      halo(map.halo()) {}
+
+/******************************************************************************
+ * fillHalo: sets the ghost cells of map, corners included, from its border
+ * under policy.
+ ******************************************************************************/
+void fillHalo(HeightmapView map, BorderPolicy policy);
+
+/******************************************************************************
+ * writeHeightmap: dumps the map row by row as raw 32 bit floats, without
+ * the row padding. Returns false if the file could not be written.
+ ******************************************************************************/
+bool writeHeightmap(const char *path, HeightmapView map);
+
+#endif
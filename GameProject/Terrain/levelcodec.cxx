@@ -0,0 +1,372 @@
+/*! \file levelcodec.cxx
+ * Hierarchical heightmap compression. The range coder is the carry-less
+ * binary coder of LZMA: 11 bit probabilities that adapt by 1/32 of the
+ * error after every bit.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "levels.h"
+#include "levelcodec.h"
+
+static const int PROB_BITS = 11;
+static const int PROB_MOVE = 5;
+static const uint32_t RANGE_TOP = 1u << 24;
+static const int MAX_EXPONENT = 30;     // |q| < 2^31
+//every sample codes at least one bit, and a bit model adapts no further
+//than 2017/2048, about 0.022 bits, so a byte holds at most ~364 samples
+static const uint64_t MAX_SAMPLES_PER_BYTE = 512;
+
+/******************************************************************************
+ * RangeEncoder: writes bits to out. flush() must follow the last bit.
+ ******************************************************************************/
+class RangeEncoder {
+public:
+    explicit RangeEncoder(std::vector<unsigned char> &out)
+        : out(out), low(0), range(0xFFFFFFFFu), cache(0), pending(1) {}
+
+    void bit(uint16_t &prob, int b){
+        uint32_t bound = (range >> PROB_BITS) * prob;
+        if (!b){
+            range = bound;
+            prob += ((1 << PROB_BITS) - prob) >> PROB_MOVE;
+        } else {
+            low += bound;
+            range -= bound;
+            prob -= prob >> PROB_MOVE;
+        }
+        normalize();
+    }
+
+    /**************************************************************************
+     * direct: the low count bits of value, most significant first, each
+     * with probability one half.
+     **************************************************************************/
+    void direct(uint32_t value, int count){
+        for (int i = count - 1; i >= 0; i--){
+            range >>= 1;
+            if ((value >> i) & 1)
+                low += range;
+            normalize();
+        }
+    }
+
+    void flush(){
+        for (int i = 0; i < 5; i++)
+            shiftLow();
+    }
+
+private:
+    void normalize(){
+        while (range < RANGE_TOP){
+            range <<= 8;
+            shiftLow();
+        }
+    }
+
+    //a byte is held back while it could still take a carry
+    void shiftLow(){
+        if ((uint32_t)low < 0xFF000000u || (low >> 32) != 0){
+            unsigned char carry = (unsigned char)(low >> 32);
+            unsigned char held = cache;
+            do {
+                out.push_back(held + carry);
+                held = 0xFF;
+            } while (--pending != 0);
+            cache = (unsigned char)(low >> 24);
+        }
+        pending++;
+        low = (low & 0x00FFFFFFu) << 8;
+    }
+
+    std::vector<unsigned char> &out;
+    uint64_t low;
+    uint32_t range;
+    unsigned char cache;
+    uint64_t pending;
+};
+
+/******************************************************************************
+ * RangeDecoder: reads what RangeEncoder wrote. Reading past the end gives
+ * zero bytes, so a damaged stream decodes to garbage but never overruns.
+ ******************************************************************************/
+class RangeDecoder {
+public:
+    RangeDecoder(const unsigned char *data, size_t bytes)
+        : data(data), end(data + bytes), range(0xFFFFFFFFu), code(0) {
+        for (int i = 0; i < 5; i++)
+            code = (code << 8) | next();
+    }
+
+    int bit(uint16_t &prob){
+        uint32_t bound = (range >> PROB_BITS) * prob;
+        int b;
+        if (code < bound){
+            range = bound;
+            prob += ((1 << PROB_BITS) - prob) >> PROB_MOVE;
+            b = 0;
+        } else {
+            code -= bound;
+            range -= bound;
+            prob -= prob >> PROB_MOVE;
+            b = 1;
+        }
+        normalize();
+        return b;
+    }
+
+    uint32_t direct(int count){
+        uint32_t value = 0;
+        for (int i = 0; i < count; i++){
+            range >>= 1;
+            int b = code >= range;
+            if (b)
+                code -= range;
+            value = (value << 1) | b;
+            normalize();
+        }
+        return value;
+    }
+
+private:
+    unsigned char next(){
+        return data < end ? *data++ : 0;
+    }
+
+    void normalize(){
+        while (range < RANGE_TOP){
+            range <<= 8;
+            code = (code << 8) | next();
+        }
+    }
+
+    const unsigned char *data;
+    const unsigned char *end;
+    uint32_t range;
+    uint32_t code;
+};
+
+/******************************************************************************
+ * Residuals: adaptive models for one kind of residual. A residual q is
+ * zero or not, then its sign, then e = floor(log2 |q|) in unary, the bit
+ * under the leading one modelled per e and the rest sent direct.
+ ******************************************************************************/
+struct Residuals {
+    uint16_t zero;
+    uint16_t sign;
+    uint16_t exponent[MAX_EXPONENT + 1];
+    uint16_t top[MAX_EXPONENT + 1];
+
+    Residuals(){
+        zero = sign = 1 << (PROB_BITS - 1);
+        for (int i = 0; i <= MAX_EXPONENT; i++)
+            exponent[i] = top[i] = 1 << (PROB_BITS - 1);
+    }
+
+    void encode(RangeEncoder &rc, int32_t q){
+        rc.bit(zero, q != 0);
+        if (q == 0)
+            return;
+        rc.bit(sign, q < 0);
+        uint32_t m = q < 0 ? -(uint32_t)q : q;
+        int e = 0;
+        while ((m >> (e + 1)) != 0)
+            e++;
+        for (int i = 0; i < e; i++)
+            rc.bit(exponent[i], 1);
+        if (e < MAX_EXPONENT)
+            rc.bit(exponent[e], 0);
+        if (e > 0){
+            rc.bit(top[e], (m >> (e - 1)) & 1);
+            rc.direct(m, e - 1);
+        }
+    }
+
+    int32_t decode(RangeDecoder &rc){
+        if (!rc.bit(zero))
+            return 0;
+        int negative = rc.bit(sign);
+        int e = 0;
+        while (e < MAX_EXPONENT && rc.bit(exponent[e]))
+            e++;
+        uint32_t m = 1;
+        if (e > 0){
+            m = (m << 1) | rc.bit(top[e]);
+            m = (m << (e - 1)) | rc.direct(e - 1);
+        }
+        return negative ? -(int32_t)m : (int32_t)m;
+    }
+};
+
+/******************************************************************************
+ * codeLevel: visits the samples level adds, in coding order, and stores
+ * sample(prediction, kind) at each. kind is 0 for corners and square
+ * centres, 1 for edge midpoints. Encoder and decoder share it so their
+ * predictions agree to the bit.
+ ******************************************************************************/
+template <class Sample>
+static void codeLevel(HeightmapView recon, int level, Sample sample){
+    const int last = recon.width - 1;
+    if (level == 0){
+        recon[0][0] = sample(0.0f, 0);
+        recon[0][last] = sample(0.0f, 0);
+        recon[last][0] = sample(0.0f, 0);
+        recon[last][last] = sample(0.0f, 0);
+        return;
+    }
+    const int incr = last >> (level - 1);
+    const int half = incr / 2;
+    for (int z = 0; z < last; z += incr){
+        for (int x = 0; x < last; x += incr){
+            float p = (recon[z][x] + recon[z][x+incr] + recon[z+incr][x] + recon[z+incr][x+incr]) / 4;
+            recon[z+half][x+half] = sample(p, 0);
+        }
+    }
+    for (int z = 0; z <= last; z += half){
+        for (int x = (z + half) % incr; x <= last; x += incr){
+            float total = 0.0f;
+            int n = 0;
+            if (z > 0)    { total += recon[z-half][x]; n++; }
+            if (z < last) { total += recon[z+half][x]; n++; }
+            if (x > 0)    { total += recon[z][x-half]; n++; }
+            if (x < last) { total += recon[z][x+half]; n++; }
+            recon[z][x] = sample(total / n, 1);
+        }
+    }
+}
+
+/******************************************************************************
+ * levelOrder: the positions codeLevel visits, for the encoder to read the
+ * original samples in the same order.
+ ******************************************************************************/
+static void levelOrder(int size, int level, std::vector<int> &order){
+    const int last = size - 1;
+    order.clear();
+    if (level == 0){
+        order.push_back(0);
+        order.push_back(last);
+        order.push_back(last * size);
+        order.push_back(last * size + last);
+        return;
+    }
+    const int incr = last >> (level - 1);
+    const int half = incr / 2;
+    for (int z = 0; z < last; z += incr)
+        for (int x = 0; x < last; x += incr)
+            order.push_back((z + half) * size + x + half);
+    for (int z = 0; z <= last; z += half)
+        for (int x = (z + half) % incr; x <= last; x += incr)
+            order.push_back(z * size + x);
+}
+
+static void put32(std::vector<unsigned char> &out, size_t at, uint32_t value){
+    memcpy(&out[at], &value, sizeof(value));
+}
+
+bool encodeLevels(HeightmapView map, float maxError, std::vector<unsigned char> &out){
+    if (map.width != map.height || !isPowerOfTwoPlusOne(map.width) || map.width > SIZED_MAX
+        || !(maxError > 0.0f))
+        return false;
+    const int size = map.width;
+    int levels = 1;
+    while ((1 << (levels - 1)) < size - 1)
+        levels++;
+
+    LevelCodecHeader head;
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, LEVELCODEC_MAGIC, sizeof(head.magic));
+    head.version = LEVELCODEC_VERSION;
+    head.size = size;
+    head.levels = levels;
+    head.step = 2.0f * maxError;
+
+    const size_t start = out.size();
+    out.resize(start + sizeof(head) + (levels + 1) * sizeof(uint32_t));
+    memcpy(&out[start], &head, sizeof(head));
+    const size_t table = start + sizeof(head);
+    const size_t streams = table + (levels + 1) * sizeof(uint32_t);
+
+    Heightmap recon(size);
+    std::vector<int> order;
+    const float step = head.step;
+    const float limit = (float)(1u << MAX_EXPONENT);
+    for (int level = 0; level < levels; level++){
+        put32(out, table + level * sizeof(uint32_t), out.size() - streams);
+        levelOrder(size, level, order);
+        RangeEncoder rc(out);
+        Residuals models[2];
+        size_t i = 0;
+        codeLevel(recon.view(), level, [&](float p, int kind){
+            int at = order[i++];
+            float r = (map[at / size][at % size] - p) / step;
+            r = r < -limit ? -limit : r > limit ? limit : r;
+            int32_t q = (int32_t)lrintf(r);
+            models[kind].encode(rc, q);
+            return p + q * step;
+        });
+        rc.flush();
+    }
+    put32(out, table + levels * sizeof(uint32_t), out.size() - streams);
+    return true;
+}
+
+LevelDecoder::LevelDecoder() : streams(NULL), side(0), count(0), done(0), quantum(0.0f) {}
+
+bool LevelDecoder::open(const unsigned char *data, size_t bytes){
+    LevelCodecHeader head;
+    if (bytes < sizeof(head))
+        return false;
+    memcpy(&head, data, sizeof(head));
+    if (memcmp(head.magic, LEVELCODEC_MAGIC, sizeof(head.magic)) != 0
+        || head.version != LEVELCODEC_VERSION || !isPowerOfTwoPlusOne(head.size)
+        || head.size > (uint32_t)SIZED_MAX
+        || head.levels == 0 || head.levels > 32
+        || (1u << (head.levels - 1)) != head.size - 1 || !(head.step > 0.0f))
+        return false;
+    size_t tableBytes = (head.levels + 1) * sizeof(uint32_t);
+    if (bytes < sizeof(head) + tableBytes)
+        return false;
+    offsets.resize(head.levels + 1);
+    memcpy(&offsets[0], data + sizeof(head), tableBytes);
+    for (uint32_t l = 0; l < head.levels; l++)
+        if (offsets[l] > offsets[l + 1])
+            return false;
+    if (offsets[0] != 0 || sizeof(head) + tableBytes + offsets[head.levels] > bytes)
+        return false;
+    //too few bytes to code that many samples: a damaged or made up header,
+    //refused before the map is allocated
+    const uint64_t samples = (uint64_t)head.size * head.size;
+    if (samples > MAX_SAMPLES_PER_BYTE * (offsets[head.levels] + (uint64_t)1))
+        return false;
+
+    streams = data + sizeof(head) + tableBytes;
+    side = head.size;
+    count = head.levels;
+    done = 0;
+    quantum = head.step;
+    recon.allocate(side, side);
+    return true;
+}
+
+bool LevelDecoder::refine(){
+    if (done >= count)
+        return false;
+    RangeDecoder rc(streams + offsets[done], levelBytes(done));
+    Residuals models[2];
+    const float step = quantum;
+    codeLevel(recon.view(), done, [&](float p, int kind){
+        return p + models[kind].decode(rc) * step;
+    });
+    done++;
+    return true;
+}
+
+void LevelDecoder::lod(HeightmapView out) const {
+    const int n = lodSize();
+    if (n == 0)
+        return;
+    const int stride = (side - 1) / (n - 1);
+    for (int z = 0; z < n; z++)
+        for (int x = 0; x < n; x++)
+            out[z][x] = recon[z * stride][x * stride];
+}
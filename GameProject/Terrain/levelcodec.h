@@ -0,0 +1,105 @@
+/*! \file levelcodec.h
+ * Hierarchical heightmap compression. A 2n+1 map is coded the way the
+ * midpoint generators build it: the four corners first, then level by
+ * level every new sample as the average of its already decoded neighbours
+ * (four corners for a square centre, the neighbours inside the map for an
+ * edge midpoint) plus a residual. Residuals are quantized to a fixed step
+ * and range coded with adaptive bit models. For a generated map they are
+ * about the size of that level's random displacement, so the bit count
+ * shrinks with every level just as the displacement does.
+ *
+ * Every level is its own stream behind an offset table: decoding can stop
+ * after any level and has a complete coarser map, and a reader that wants
+ * only a low LOD never touches the bytes of the finer levels.
+ */
+
+#ifndef LEVELCODEC_H
+#define LEVELCODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "heightmap.h"
+
+const char LEVELCODEC_MAGIC[8] = "TERRLVL";
+const uint32_t LEVELCODEC_VERSION = 1;
+
+/******************************************************************************
+ * LevelCodecHeader: start of a coded map, followed by levels + 1 uint32
+ * offsets (level l is the bytes offset[l] .. offset[l+1] after the table)
+ * and the level streams. Level 0 holds the corners, level l > 0 the
+ * samples that halve the spacing from (size-1) >> (l-1).
+ ******************************************************************************/
+struct LevelCodecHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t size;          // samples per side, 2n+1
+    uint32_t levels;        // n + 1
+    float step;             // quantization step, twice the largest error
+};
+
+/******************************************************************************
+ * encodeLevels: appends map, which must be square and 2n+1 and at most
+ * SIZED_MAX (levels.h) on a side, coded so no sample is off by more than
+ * maxError, give or take the float rounding of the heights themselves.
+ * False for any other shape or a maxError that is not positive.
+ ******************************************************************************/
+bool encodeLevels(HeightmapView map, float maxError, std::vector<unsigned char> &out);
+
+/******************************************************************************
+ * LevelDecoder: progressive decoding. open() reads the header, each
+ * refine() decodes one more level into map(), lod() copies out the part
+ * decoded so far.
+ ******************************************************************************/
+class LevelDecoder {
+public:
+    LevelDecoder();
+
+    /**************************************************************************
+     * open: data must stay valid while decoding. False if it is not a coded
+     * map of this version, is truncated, or claims a size encodeLevels()
+     * would not write or its streams are too short for; nothing is
+     * allocated then.
+     **************************************************************************/
+    bool open(const unsigned char *data, size_t bytes);
+
+    int size() const { return side; }
+    int levels() const { return count; }
+    int decoded() const { return done; }
+    float step() const { return quantum; }
+
+    /**************************************************************************
+     * levelBytes: the coded size of level.
+     **************************************************************************/
+    size_t levelBytes(int level) const { return offsets[level + 1] - offsets[level]; }
+
+    /**************************************************************************
+     * refine: decodes the next level. False once every level is decoded.
+     **************************************************************************/
+    bool refine();
+
+    /**************************************************************************
+     * lodSize: side of the map decoded so far, 2^(decoded-1) + 1.
+     **************************************************************************/
+    int lodSize() const { return done == 0 ? 0 : (1 << (done - 1)) + 1; }
+
+    /**************************************************************************
+     * lod: the decoded samples, every (size-1)/(lodSize-1)th of the map,
+     * into out, which is lodSize square.
+     **************************************************************************/
+    void lod(HeightmapView out) const;
+
+    /**************************************************************************
+     * map: the full size map; only the samples of decoded levels are set.
+     **************************************************************************/
+    const Heightmap &map() const { return recon; }
+
+private:
+    const unsigned char *streams;
+    std::vector<uint32_t> offsets;
+    int side, count, done;
+    float quantum;
+    Heightmap recon;
+};
+
+#endif
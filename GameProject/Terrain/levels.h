@@ -0,0 +1,83 @@
+/*! \file levels.h
+ * Level arithmetic shared by the midpoint style generators. A 2n+1 grid is
+ * refined from step size-1 down to step 2, one level per halving, and the
+ * displacement shrinks by the same factor every level. All of it is
+ * constexpr so a generator instantiated for one grid size gets its level
+ * count, strides and displacements as constants; the sizes in
+ * SIZED_MIN .. SIZED_MAX are instantiated ahead of time and picked at run
+ * time by sizedIndex().
+ */
+
+#ifndef LEVELS_H
+#define LEVELS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+const double DISPLACEMENT_DECAY = 0.68302012837719772;   // pow(2.0, -0.55), per level
+
+const int SIZED_MIN = 33;       // smallest grid with its own instantiation
+const int SIZED_MAX = 8193;     // largest
+
+/******************************************************************************
+ * isPowerOfTwoPlusOne: true for 3, 5, 9, ... 2n+1 sizes needed by the
+ * midpoint style generators.
+ ******************************************************************************/
+constexpr bool isPowerOfTwoPlusOne(int size){
+    return size - 1 > 1 && ((size - 1) & (size - 2)) == 0;
+}
+
+/******************************************************************************
+ * gridLevels: levels needed to refine a 2n+1 grid, i.e. n.
+ ******************************************************************************/
+constexpr int gridLevels(int size){
+    return size <= 2 ? 0 : 1 + gridLevels((size - 1)/2 + 1);
+}
+
+/******************************************************************************
+ * levelDisplacement: displacement of level k (0 the first), starting from
+ * start and rounded to float after each level like a running product.
+ ******************************************************************************/
+constexpr float levelDisplacement(float start, int k){
+    return k == 0 ? start : (float)(levelDisplacement(start, k - 1) * DISPLACEMENT_DECAY);
+}
+
+/******************************************************************************
+ * fixed: FIXED, or n when FIXED is 0. Code shared by the sized and the
+ * generic generators reads its size and step through this, so in a sized
+ * instantiation the compiler sees constants.
+ ******************************************************************************/
+template <int FIXED>
+inline int fixed(int n){
+    return FIXED != 0 ? FIXED : n;
+}
+
+const int SIZED_COUNT = gridLevels(SIZED_MAX) - gridLevels(SIZED_MIN) + 1;
+
+/******************************************************************************
+ * sizedIndex: slot of size in a table of the SIZED_COUNT instantiations,
+ * smallest first, or -1 if there is none for it.
+ ******************************************************************************/
+inline int sizedIndex(int size){
+    if (!isPowerOfTwoPlusOne(size) || size < SIZED_MIN || size > SIZED_MAX)
+        return -1;
+    return gridLevels(size) - gridLevels(SIZED_MIN);
+}
+
+/******************************************************************************
+ * requireGrid: exits with a message unless the map is size x size, or with
+ * size 0 square with any 2n+1 side. The generators index both axes with
+ * one size, so any other map would be read and written past its edge.
+ ******************************************************************************/
+inline void requireGrid(const char *name, int width, int height, int size){
+    if (size != 0 && (width != size || height != size)){
+        fprintf(stderr, "%s needs a %d x %d map, not %d x %d\n", name, size, size, width, height);
+        exit(1);
+    }
+    if (size == 0 && (width != height || !isPowerOfTwoPlusOne(width))){
+        fprintf(stderr, "%s needs a square 2n+1 map, not %d x %d\n", name, width, height);
+        exit(1);
+    }
+}
+
+#endif
@@ -0,0 +1,235 @@
+/*! \file lod.cxx
+ * Chunked level of detail.
+ */
+
+#include <math.h>
+#include <algorithm>
+#include "lod.h"
+
+LodView lodView(const float eye[3], const float forward[3], float fovY, float aspect,
+                int viewportHeight, float tolerance){
+    LodView view;
+    float tanY = tanf(0.5f * fovY), tanX = tanY * aspect;
+    for (int k = 0; k < 3; k++)
+        view.eye[k] = eye[k];
+    view.projection = viewportHeight / (2.0f * tanY);
+    view.tolerance = tolerance;
+    view.morphStart = 0.5f;
+
+    float length = sqrtf(forward[0] * forward[0] + forward[1] * forward[1] + forward[2] * forward[2]);
+    float f[3] = { forward[0] / length, forward[1] / length, forward[2] / length };
+    //right is forward x up, up is right x forward
+    float across = sqrtf(f[0] * f[0] + f[2] * f[2]);
+    float r[3] = { -f[2] / across, 0.0f, f[0] / across };
+    float u[3] = { r[1] * f[2] - r[2] * f[1], r[2] * f[0] - r[0] * f[2], r[0] * f[1] - r[1] * f[0] };
+    const float sides[4][2] = { { tanX, -1.0f }, { tanX, 1.0f }, { tanY, -1.0f }, { tanY, 1.0f } };
+    view.planeCount = 4;
+    for (int p = 0; p < 4; p++){
+        const float *towards = p < 2 ? r : u;
+        float *plane = view.planes[p];
+        plane[3] = 0.0f;
+        for (int k = 0; k < 3; k++){
+            plane[k] = sides[p][0] * f[k] + sides[p][1] * towards[k];
+            plane[3] -= plane[k] * eye[k];
+        }
+    }
+    return view;
+}
+
+LodTree::LodTree() : x0(0.0f), z0(0.0f), spacing(1.0f), cells(LOD_LEAF_CELLS) {}
+
+bool LodTree::build(HeightmapView heights, float left, float top, float step, int leafCells, ThreadPool *pool){
+    int n = heights.width - 1;
+    if (heights.width != heights.height || n < 1 || (n & (n - 1)) != 0
+        || leafCells < 1 || (leafCells & (leafCells - 1)) != 0)
+        return false;
+    map = heights;
+    x0 = left;
+    z0 = top;
+    spacing = step;
+    cells = std::min(leafCells, n);
+
+    tree.clear();
+    LodNode root = { 0, 0, n / cells, -1, -1, 0.0f, 0.0f, 0.0f };
+    tree.push_back(root);
+    for (size_t i = 0; i < tree.size(); i++){
+        if (tree[i].stride == 1)
+            continue;
+        int s = tree[i].stride / 2, half = cells * s;
+        tree[i].child = tree.size();
+        for (int k = 0; k < 4; k++){
+            LodNode child = { tree[i].row + (k / 2) * half, tree[i].col + (k % 2) * half, s,
+                              (int)i, -1, 0.0f, 0.0f, 0.0f };
+            tree.push_back(child);
+        }
+    }
+    parallelFor(pool, 0, tree.size(), [&](int first, int last){
+        for (int i = first; i < last; i++)
+            measure(tree[i]);
+    });
+    //children come after their parent, so going backwards folds each
+    //subtree into its root before that root is folded further up
+    for (size_t i = tree.size() - 1; i > 0; i--){
+        LodNode &parent = tree[tree[i].parent];
+        parent.error = std::max(parent.error, tree[i].error);
+    }
+    return true;
+}
+
+/******************************************************************************
+ * measure: node's height range and how far its surface, the two triangles
+ * of every cell split along the same diagonal as TerrainMesh, strays from
+ * the samples it skips.
+ ******************************************************************************/
+void LodTree::measure(LodNode &node) const {
+    const int s = node.stride, span = cells * s;
+    float lo = map[node.row][node.col], hi = lo, worst = 0.0f;
+    for (int r = node.row; r <= node.row + span; r++){
+        const float *row = map[r];
+        for (int c = node.col; c <= node.col + span; c++){
+            lo = std::min(lo, row[c]);
+            hi = std::max(hi, row[c]);
+        }
+    }
+    if (s > 1){
+        const float inverse = 1.0f / s;
+        for (int i = 0; i < cells; i++){
+            int r0 = node.row + i * s;
+            for (int j = 0; j < cells; j++){
+                int c0 = node.col + j * s;
+                float h00 = map[r0][c0], h01 = map[r0][c0 + s];
+                float h10 = map[r0 + s][c0], h11 = map[r0 + s][c0 + s];
+                for (int y = 0; y <= s; y++){
+                    const float *row = map[r0 + y];
+                    float v = y * inverse;
+                    for (int x = 0; x <= s; x++){
+                        float u = x * inverse;
+                        float surface = u + v <= 1.0f
+                                      ? h00 + u * (h01 - h00) + v * (h10 - h00)
+                                      : h11 + (1.0f - u) * (h10 - h11) + (1.0f - v) * (h01 - h11);
+                        worst = std::max(worst, fabsf(row[c0 + x] - surface));
+                    }
+                }
+            }
+        }
+    }
+    node.minHeight = lo;
+    node.maxHeight = hi;
+    node.error = worst;
+}
+
+void LodTree::select(const LodView &view, std::vector<LodSelection> &out) const {
+    out.clear();
+    if (!tree.empty())
+        visit(view, 0, INFINITY, out);
+}
+
+/******************************************************************************
+ * visit: selects node or its descendants. parentSwitch is the distance
+ * inside which the parent splits; the node morphs towards the parent's
+ * surface as it nears that distance.
+ ******************************************************************************/
+void LodTree::visit(const LodView &view, int index, float parentSwitch, std::vector<LodSelection> &out) const {
+    const LodNode &node = tree[index];
+    float extent = cells * node.stride * spacing;
+    float lo[3] = { x0 + node.col * spacing, node.minHeight, z0 + node.row * spacing };
+    float hi[3] = { lo[0] + extent, node.maxHeight, lo[2] + extent };
+    for (int p = 0; p < view.planeCount; p++){
+        const float *plane = view.planes[p];
+        float inside = plane[3];
+        for (int k = 0; k < 3; k++)
+            inside += plane[k] * (plane[k] > 0.0f ? hi[k] : lo[k]);
+        if (inside < 0.0f)
+            return;
+    }
+    float squared = 0.0f;
+    for (int k = 0; k < 3; k++){
+        float gap = std::max(std::max(lo[k] - view.eye[k], view.eye[k] - hi[k]), 0.0f);
+        squared += gap * gap;
+    }
+    float distance = sqrtf(squared);
+    float screen = distance > 0.0f ? node.error * view.projection / distance
+                                   : (node.error > 0.0f ? INFINITY : 0.0f);
+    if (node.child < 0 || screen <= view.tolerance){
+        float morph = 0.0f;
+        if (parentSwitch < INFINITY){
+            morph = (distance / parentSwitch - view.morphStart) / (1.0f - view.morphStart);
+            morph = std::min(std::max(morph, 0.0f), 1.0f);
+        }
+        LodSelection selected = { index, morph, screen };
+        out.push_back(selected);
+        return;
+    }
+    float split = node.error * view.projection / view.tolerance;
+    for (int k = 0; k < 4; k++)
+        visit(view, node.child + k, split, out);
+}
+
+/******************************************************************************
+ * parentHeight: the height of node's vertex (i, j) in its parent's
+ * surface. Vertices the parent skips sit halfway along one of its edges
+ * or diagonals.
+ ******************************************************************************/
+float LodTree::parentHeight(const LodNode &node, int i, int j) const {
+    const int s = node.stride, r = node.row + i * s, c = node.col + j * s;
+    if (node.parent < 0)
+        return map[r][c];
+    const LodNode &parent = tree[node.parent];
+    bool oddRow = ((r - parent.row) / s) & 1, oddCol = ((c - parent.col) / s) & 1;
+    if (oddRow && oddCol)
+        return 0.5f * (map[r - s][c + s] + map[r + s][c - s]);
+    if (oddRow)
+        return 0.5f * (map[r - s][c] + map[r + s][c]);
+    if (oddCol)
+        return 0.5f * (map[r][c - s] + map[r][c + s]);
+    return map[r][c];
+}
+
+void LodTree::chunk(int index, LodChunk &out) const {
+    const LodNode &node = tree[index];
+    const int s = node.stride, side = cells + 1;
+    out.vertices.clear();
+    out.indices.clear();
+    out.vertices.reserve(side * side + 4 * cells);
+    out.indices.reserve(3 * chunkTriangles());
+    for (int i = 0; i <= cells; i++){
+        int r = node.row + i * s;
+        for (int j = 0; j <= cells; j++){
+            int c = node.col + j * s;
+            LodVertex v = { { x0 + c * spacing, map[r][c], z0 + r * spacing }, parentHeight(node, i, j) };
+            out.vertices.push_back(v);
+        }
+    }
+    for (int i = 0; i < cells; i++){
+        for (int j = 0; j < cells; j++){
+            uint32_t a = i * side + j, b = a + side;
+            uint32_t cell[6] = { a, b, a + 1, a + 1, b, b + 1 };
+            out.indices.insert(out.indices.end(), cell, cell + 6);
+        }
+    }
+
+    //the border once round, each skirt vertex straight below its border one
+    std::vector<uint32_t> ring;
+    ring.reserve(4 * cells);
+    for (int j = 0; j < cells; j++)
+        ring.push_back(j);
+    for (int i = 0; i < cells; i++)
+        ring.push_back(i * side + cells);
+    for (int j = cells; j > 0; j--)
+        ring.push_back(cells * side + j);
+    for (int i = cells; i > 0; i--)
+        ring.push_back(i * side);
+    float depth = node.error + (node.parent >= 0 ? tree[node.parent].error : 0.0f);
+    uint32_t base = out.vertices.size(), m = ring.size();
+    for (uint32_t k = 0; k < m; k++){
+        LodVertex v = out.vertices[ring[k]];
+        v.position[1] -= depth;
+        v.morphHeight -= depth;
+        out.vertices.push_back(v);
+    }
+    for (uint32_t k = 0; k < m; k++){
+        uint32_t a = ring[k], b = ring[(k + 1) % m], sa = base + k, sb = base + (k + 1) % m;
+        uint32_t skirt[6] = { a, sa, b, b, sa, sb };
+        out.indices.insert(out.indices.end(), skirt, skirt + 6);
+    }
+}
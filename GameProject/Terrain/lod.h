@@ -0,0 +1,119 @@
+/*! \file lod.h
+ * Chunked level of detail. A quadtree over a (2^n+1)^2 heightmap whose
+ * every node is the same (leafCells+1)^2 grid of samples, the leaves at
+ * full resolution and each level up at twice the stride. build() measures
+ * how far each node's coarse surface strays from the full map; select()
+ * keeps the coarsest nodes whose error projects to at most a given number
+ * of pixels, so the triangle count follows the screen rather than the map.
+ *
+ * chunk() emits a node's mesh with skirts hanging off its border, which
+ * hide the cracks where neighbours of different levels meet, and with the
+ * height every vertex takes in the parent's surface. A renderer blends
+ * towards that by the selection's morph factor so nodes do not pop when
+ * they switch level. Nothing here touches GL.
+ */
+
+#ifndef LOD_H
+#define LOD_H
+
+#include <stdint.h>
+#include <vector>
+#include "heightmap.h"
+#include "threadpool.h"
+
+const int LOD_LEAF_CELLS = 32;      // cells along a node's side
+
+struct LodNode {
+    int row, col;           // top left sample
+    int stride;             // samples between vertices, 1 for a leaf
+    int parent;             // -1 for the root
+    int child;              // first of four, -1 for a leaf
+    float error;            // largest height error, at least the children's
+    float minHeight, maxHeight;
+};
+
+/******************************************************************************
+ * LodView: what select() needs of the camera. projection turns an error
+ * at unit distance into pixels, the viewport height over 2 tan(fovY / 2).
+ * Samples outside any of the planes (ax + by + cz + d < 0) are culled.
+ ******************************************************************************/
+struct LodView {
+    float eye[3];
+    float projection;
+    float tolerance;        // largest screen error in pixels
+    float morphStart;       // morphing starts at this fraction of the switch distance
+    int planeCount;
+    float planes[6][4];
+};
+
+/******************************************************************************
+ * lodView: a view from eye looking along forward with y up, the four side
+ * planes of its frustum and no near or far plane.
+ ******************************************************************************/
+LodView lodView(const float eye[3], const float forward[3], float fovY, float aspect,
+                int viewportHeight, float tolerance);
+
+struct LodSelection {
+    int node;
+    float morph;            // 0 for the node's own heights, 1 for its parent's
+    float screenError;      // pixels
+};
+
+struct LodVertex {
+    float position[3];      // x, height, z
+    float morphHeight;      // the height in the parent's surface
+};
+
+struct LodChunk {
+    std::vector<LodVertex> vertices;    // grid row major, then the skirt
+    std::vector<uint32_t> indices;      // triangles
+};
+
+/******************************************************************************
+ * lodHeight: v's height at morph factor morph.
+ ******************************************************************************/
+inline float lodHeight(const LodVertex &v, float morph){
+    return v.position[1] + morph * (v.morphHeight - v.position[1]);
+}
+
+class LodTree {
+public:
+    LodTree();
+
+    /**************************************************************************
+     * build: the tree over map, sample (r, c) at x = x0 + c * spacing,
+     * z = z0 + r * spacing. leafCells must be a power of two; a map
+     * smaller than one leaf is a single node. map is not copied and must
+     * outlive the tree. False unless map is square with 2^n+1 samples.
+     **************************************************************************/
+    bool build(HeightmapView map, float x0, float z0, float spacing,
+               int leafCells = LOD_LEAF_CELLS, ThreadPool *pool = NULL);
+
+    /**************************************************************************
+     * select: replaces out with the nodes to draw for view, which together
+     * cover every part of the map not culled.
+     **************************************************************************/
+    void select(const LodView &view, std::vector<LodSelection> &out) const;
+
+    /**************************************************************************
+     * chunk: node's mesh. The skirt drops by the node's and its parent's
+     * error together, enough to cover a neighbour one level coarser.
+     **************************************************************************/
+    void chunk(int node, LodChunk &out) const;
+
+    const std::vector<LodNode> &nodes() const { return tree; }
+    int leafCells() const { return cells; }
+    int chunkTriangles() const { return 2 * cells * cells + 8 * cells; }
+
+private:
+    void measure(LodNode &node) const;
+    void visit(const LodView &view, int node, float parentSwitch, std::vector<LodSelection> &out) const;
+    float parentHeight(const LodNode &node, int i, int j) const;
+
+    HeightmapView map;
+    float x0, z0, spacing;
+    int cells;
+    std::vector<LodNode> tree;      // level by level from the root
+};
+
+#endif
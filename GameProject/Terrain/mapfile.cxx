@@ -0,0 +1,231 @@
+/*! \file mapfile.cxx
+ * Tiled heightmap files.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include "mapfile.h"
+#include "mesh.h"
+
+/******************************************************************************
+ * encode: one tile of map into out, edges repeated past the map.
+ ******************************************************************************/
+static void encode(HeightmapView map, const MapFileHeader &head, int tx, int tz, unsigned char *out){
+    const int tile = head.tile;
+    for (int r = 0; r < tile; r++){
+        int z = tz * tile + r;
+        const float *row = map[z < map.height ? z : map.height - 1];
+        for (int c = 0; c < tile; c++){
+            int x = tx * tile + c;
+            float v = row[x < map.width ? x : map.width - 1];
+            if (head.type == MAP_FLOAT32){
+                ((float *)out)[r * tile + c] = v;
+            } else {
+                float q = head.scale > 0.0f ? (v - head.minHeight) / head.scale : 0.0f;
+                q = q < 0.0f ? 0.0f : q > 65535.0f ? 65535.0f : q;
+                ((uint16_t *)out)[r * tile + c] = (uint16_t)lrintf(q);
+            }
+        }
+    }
+}
+
+bool writeMapFile(const char *path, HeightmapView map, const MapFileInfo &info, MapType type, int tile){
+    if (tile < 1){
+        errno = EINVAL;
+        return false;
+    }
+    MapFileHeader head;
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, MAPFILE_MAGIC, sizeof(head.magic));
+    head.version = MAPFILE_VERSION;
+    head.endian = MAPFILE_ENDIAN;
+    head.type = type;
+    head.width = map.width;
+    head.height = map.height;
+    head.tile = tile;
+    head.tilesX = (map.width + tile - 1) / tile;
+    head.tilesZ = (map.height + tile - 1) / tile;
+    head.seed = info.seed;
+    size_t sampleBytes = type == MAP_FLOAT32 ? sizeof(float) : sizeof(uint16_t);
+    head.tileBytes = ((size_t)tile * tile * sampleBytes + HEIGHTMAP_ALIGN - 1) / HEIGHTMAP_ALIGN
+                   * HEIGHTMAP_ALIGN;
+    head.dataOffset = MAPFILE_DATA;
+    snprintf(head.algorithm, sizeof(head.algorithm), "%s", info.algorithm ? info.algorithm : "");
+    snprintf(head.params, sizeof(head.params), "%s", info.params ? info.params : "");
+
+    if (type == MAP_UINT16){
+        float lo = map[0][0], hi = map[0][0];
+        for (int z = 0; z < map.height; z++){
+            for (int x = 0; x < map.width; x++){
+                lo = fminf(lo, map[z][x]);
+                hi = fmaxf(hi, map[z][x]);
+            }
+        }
+        head.minHeight = lo;
+        head.scale = (hi - lo) / 65535.0f;
+    }
+
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL)
+        return false;
+    std::vector<unsigned char> block(MAPFILE_DATA, 0);
+    memcpy(&block[0], &head, sizeof(head));
+    bool ok = fwrite(&block[0], 1, block.size(), fp) == block.size();
+
+    block.assign(head.tileBytes, 0);
+    for (uint32_t tz = 0; tz < head.tilesZ && ok; tz++){
+        for (uint32_t tx = 0; tx < head.tilesX && ok; tx++){
+            encode(map, head, tx, tz, &block[0]);
+            ok = fwrite(&block[0], 1, block.size(), fp) == block.size();
+        }
+    }
+    if (fclose(fp) != 0)
+        ok = false;
+    return ok;
+}
+
+/******************************************************************************
+ * hasSuffix: true if path ends in suffix.
+ ******************************************************************************/
+static bool hasSuffix(const char *path, const char *suffix){
+    size_t n = strlen(path), k = strlen(suffix);
+    return n >= k && strcmp(path + n - k, suffix) == 0;
+}
+
+bool saveHeightmap(const char *path, HeightmapView map, const char *algorithm, const Options &opts){
+    if (hasSuffix(path, ".obj")){
+        //centred on the origin a unit apart, as the viewers lay it out
+        TerrainMesh mesh;
+        mesh.build(map, -(float)(map.width / 2), -(float)(map.height / 2), 1.0f);
+        return writeMeshObj(path, mesh);
+    }
+    if (!hasSuffix(path, ".tmap") && !hasSuffix(path, ".tmap16"))
+        return writeHeightmap(path, map);
+    char params[152];
+    snprintf(params, sizeof(params), "iterations=%d band=%d method=%s tolerance=%g levels=%d border=%s",
+             opts.iterations, opts.band, opts.method ? opts.method : "default",
+             opts.tolerance, opts.levels, borderPolicyName(opts.border));
+    MapFileInfo info = { opts.seed, algorithm, params };
+    return writeMapFile(path, map, info, hasSuffix(path, ".tmap16") ? MAP_UINT16 : MAP_FLOAT32);
+}
+
+MapFile::MapFile() : base(NULL), length(0), head(NULL) {}
+
+MapFile::~MapFile(){
+    close();
+}
+
+/******************************************************************************
+ * valid: the header belongs to this version and byte order and the file
+ * holds every tile it promises. The header may be anything, so every sum
+ * and product is checked against its limit by division before it is
+ * formed.
+ ******************************************************************************/
+static bool valid(const MapFileHeader &head, size_t length){
+    if (memcmp(head.magic, MAPFILE_MAGIC, sizeof(head.magic)) != 0
+        || head.version != MAPFILE_VERSION || head.endian != MAPFILE_ENDIAN)
+        return false;
+    if (head.type != MAP_FLOAT32 && head.type != MAP_UINT16)
+        return false;
+    uint64_t sampleBytes = head.type == MAP_FLOAT32 ? sizeof(float) : sizeof(uint16_t);
+    //width() and height() hand the sides out as int
+    if (head.width == 0 || head.height == 0 || head.tile == 0
+        || head.width > INT_MAX || head.height > INT_MAX
+        || head.tilesX != ((uint64_t)head.width + head.tile - 1) / head.tile
+        || head.tilesZ != ((uint64_t)head.height + head.tile - 1) / head.tile
+        || head.tileBytes / sampleBytes / head.tile < head.tile
+        || head.tileBytes % HEIGHTMAP_ALIGN != 0 || head.dataOffset % HEIGHTMAP_ALIGN != 0
+        || head.dataOffset < sizeof(head) || head.dataOffset > length)
+        return false;
+    return head.tileBytes <= (length - head.dataOffset) / head.tilesX / head.tilesZ;
+}
+
+bool MapFile::open(const char *path){
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0){
+        ::close(fd);
+        return false;
+    }
+    if ((size_t)st.st_size < sizeof(MapFileHeader)){
+        ::close(fd);
+        errno = EINVAL;
+        return false;
+    }
+    void *mapped = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    //the mapping keeps the file open
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+    if (!valid(*(const MapFileHeader *)mapped, st.st_size)){
+        munmap(mapped, st.st_size);
+        errno = EINVAL;
+        return false;
+    }
+    base = mapped;
+    length = st.st_size;
+    head = (const MapFileHeader *)mapped;
+    return true;
+}
+
+void MapFile::close(){
+    if (base != NULL)
+        munmap(base, length);
+    base = NULL;
+    length = 0;
+    head = NULL;
+}
+
+const void *MapFile::tile(int tx, int tz) const {
+    return (const char *)base + head->dataOffset + ((uint64_t)tz * head->tilesX + tx) * head->tileBytes;
+}
+
+const float *MapFile::tileFloat(int tx, int tz) const {
+    return head->type == MAP_FLOAT32 ? (const float *)tile(tx, tz) : NULL;
+}
+
+const uint16_t *MapFile::tileUint16(int tx, int tz) const {
+    return head->type == MAP_UINT16 ? (const uint16_t *)tile(tx, tz) : NULL;
+}
+
+float MapFile::sample(int x, int z) const {
+    const int t = head->tile;
+    const void *samples = tile(x / t, z / t);
+    const int i = (z % t) * t + x % t;
+    if (head->type == MAP_FLOAT32)
+        return ((const float *)samples)[i];
+    return head->minHeight + ((const uint16_t *)samples)[i] * head->scale;
+}
+
+void MapFile::read(HeightmapView out) const {
+    const int t = head->tile;
+    for (uint32_t tz = 0; tz < head->tilesZ; tz++){
+        for (uint32_t tx = 0; tx < head->tilesX; tx++){
+            const void *samples = tile(tx, tz);
+            const int rows = std::min<int>(t, head->height - tz * t);
+            const int cols = std::min<int>(t, head->width - tx * t);
+            for (int r = 0; r < rows; r++){
+                float *dst = out[tz * t + r] + tx * t;
+                if (head->type == MAP_FLOAT32){
+                    memcpy(dst, (const float *)samples + r * t, cols * sizeof(float));
+                } else {
+                    const uint16_t *src = (const uint16_t *)samples + r * t;
+                    for (int c = 0; c < cols; c++)
+                        dst[c] = head->minHeight + src[c] * head->scale;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,127 @@
+/*! \file mapfile.h
+ * Tiled heightmap files. A page sized header records how the map was made
+ * (size, seed, algorithm and options) and is followed by square tiles of
+ * float32 or uint16 samples, row major inside the tile and tile rows top
+ * to bottom. Every tile starts on a cache line and the first on a page, so
+ * a reader can mmap the file and hand out tiles in place; only the tiles
+ * actually touched are ever read from disk. Tiles that hang over the map
+ * edge repeat the last row and column.
+ */
+
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "heightmap.h"
+#include "options.h"
+
+const char MAPFILE_MAGIC[8] = "TERRMAP";
+const uint32_t MAPFILE_VERSION = 1;
+const uint32_t MAPFILE_ENDIAN = 0x01020304;     // reads back swapped on the other byte order
+const int MAPFILE_TILE = 64;                    // default samples per tile side
+const int MAPFILE_DATA = 4096;                  // offset of the first tile
+
+enum MapType {
+    MAP_FLOAT32 = 1,
+    MAP_UINT16 = 2      // minHeight + q * scale, q in 0 .. 65535
+};
+
+/******************************************************************************
+ * MapFileHeader: the first bytes of the file, all fields in the writer's
+ * native byte order, which endian records. Fields are only ever added at
+ * the end of reserved space, with a new version.
+ ******************************************************************************/
+struct MapFileHeader {
+    char magic[8];          // MAPFILE_MAGIC
+    uint32_t version;
+    uint32_t endian;        // MAPFILE_ENDIAN
+    uint32_t type;          // MapType
+    uint32_t width, height;
+    uint32_t tile;          // samples per tile side
+    uint32_t tilesX, tilesZ;
+    uint32_t seed;
+    float minHeight;        // MAP_UINT16 only
+    float scale;            // MAP_UINT16 only
+    uint32_t reserved;
+    uint64_t tileBytes;     // distance between tiles
+    uint64_t dataOffset;    // first tile
+    char algorithm[32];     // generator, e.g. "fault"
+    char params[152];       // its options as "name=value ..."
+};
+
+static_assert(sizeof(MapFileHeader) == 256, "MapFileHeader layout changed");
+
+/******************************************************************************
+ * MapFileInfo: what the header records about where the map came from.
+ ******************************************************************************/
+struct MapFileInfo {
+    uint32_t seed;
+    const char *algorithm;
+    const char *params;
+};
+
+/******************************************************************************
+ * writeMapFile: writes map as type in tiles of tile x tile samples.
+ * Returns false if the file could not be written, with errno set, EINVAL
+ * for a tile under 1.
+ ******************************************************************************/
+bool writeMapFile(const char *path, HeightmapView map, const MapFileInfo &info,
+                  MapType type = MAP_FLOAT32, int tile = MAPFILE_TILE);
+
+/******************************************************************************
+ * saveHeightmap: --output for the generators. A path ending in .tmap gets
+ * a float32 map file, .tmap16 a uint16 one, .obj the TerrainMesh the
+ * viewers draw, anything else the raw floats of writeHeightmap(). The map
+ * file header records algorithm and opts.
+ ******************************************************************************/
+bool saveHeightmap(const char *path, HeightmapView map, const char *algorithm, const Options &opts);
+
+/******************************************************************************
+ * MapFile: a map file mapped read only. Tiles point straight into the
+ * mapping and stay valid until close().
+ ******************************************************************************/
+class MapFile {
+public:
+    MapFile();
+    ~MapFile();
+    MapFile(const MapFile &) = delete;
+    MapFile &operator=(const MapFile &) = delete;
+
+    /**************************************************************************
+     * open: maps path. False with errno set if it cannot be read, EINVAL if
+     * it is not a map file of this version and byte order or is truncated.
+     **************************************************************************/
+    bool open(const char *path);
+    void close();
+    bool isOpen() const { return head != NULL; }
+
+    const MapFileHeader &header() const { return *head; }
+    int width() const { return head->width; }
+    int height() const { return head->height; }
+
+    /**************************************************************************
+     * tile: the samples of tile (tx, tz), in the file's type. tileFloat and
+     * tileUint16 return NULL if the file holds the other type.
+     **************************************************************************/
+    const void *tile(int tx, int tz) const;
+    const float *tileFloat(int tx, int tz) const;
+    const uint16_t *tileUint16(int tx, int tz) const;
+
+    /**************************************************************************
+     * sample: the height at (x, z), decoded to float.
+     **************************************************************************/
+    float sample(int x, int z) const;
+
+    /**************************************************************************
+     * read: decodes the whole map into out, which is width x height.
+     **************************************************************************/
+    void read(HeightmapView out) const;
+
+private:
+    void *base;
+    size_t length;
+    const MapFileHeader *head;
+};
+
+#endif
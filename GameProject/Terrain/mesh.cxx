@@ -0,0 +1,142 @@
+/*! \file mesh.cxx
+ * Triangle mesh of a heightmap.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include "mesh.h"
+
+TerrainMesh::TerrainMesh()
+    : shape(MESH_TRIANGLES), w(0), h(0), spacing(1.0f), dirtyFirst(0), dirtyLast(0) {}
+
+void TerrainMesh::build(HeightmapView map, float x0, float z0, float step, MeshTopology topology){
+    w = map.width;
+    h = map.height;
+    spacing = step;
+    shape = topology;
+    verts.resize((size_t)w * h);
+    for (int r = 0; r < h; r++){
+        for (int c = 0; c < w; c++){
+            MeshVertex &v = verts[(size_t)r * w + c];
+            v.position[0] = x0 + c * step;
+            v.position[1] = map[r][c];
+            v.position[2] = z0 + r * step;
+        }
+    }
+    normals(map, 0, 0, h, w);
+
+    //cell (r, c) is the triangles (r,c) (r+1,c) (r,c+1) and
+    //(r,c+1) (r+1,c) (r+1,c+1)
+    index.clear();
+    if (shape == MESH_TRIANGLES){
+        index.reserve((size_t)(w - 1) * (h - 1) * 6);
+        for (int r = 0; r + 1 < h; r++){
+            for (int c = 0; c + 1 < w; c++){
+                uint32_t a = r * w + c, b = a + w;
+                index.push_back(a);
+                index.push_back(b);
+                index.push_back(a + 1);
+                index.push_back(a + 1);
+                index.push_back(b);
+                index.push_back(b + 1);
+            }
+        }
+    }
+    else {
+        index.reserve((size_t)(h - 1) * (2 * w + 1));
+        for (int r = 0; r + 1 < h; r++){
+            if (r > 0)
+                index.push_back(MESH_RESTART);
+            for (int c = 0; c < w; c++){
+                index.push_back(r * w + c);
+                index.push_back((r + 1) * w + c);
+            }
+        }
+    }
+    dirtyFirst = 0;
+    dirtyLast = verts.size();
+}
+
+void TerrainMesh::update(HeightmapView map, int r0, int c0, int r1, int c1){
+    r0 = std::max(r0, 0);
+    c0 = std::max(c0, 0);
+    r1 = std::min(r1, h);
+    c1 = std::min(c1, w);
+    if (r0 >= r1 || c0 >= c1)
+        return;
+    for (int r = r0; r < r1; r++)
+        for (int c = c0; c < c1; c++)
+            verts[(size_t)r * w + c].position[1] = map[r][c];
+    //a normal reads its four neighbours, so the ring around the edit moves too
+    r0 = std::max(r0 - 1, 0);
+    c0 = std::max(c0 - 1, 0);
+    r1 = std::min(r1 + 1, h);
+    c1 = std::min(c1 + 1, w);
+    normals(map, r0, c0, r1, c1);
+    markChanged(r0 * w + c0, (r1 - 1) * w + c1);
+}
+
+/******************************************************************************
+ * normals: central differences inside the map, one sided on its border.
+ ******************************************************************************/
+void TerrainMesh::normals(HeightmapView map, int r0, int c0, int r1, int c1){
+    for (int r = r0; r < r1; r++){
+        int up = std::max(r - 1, 0), down = std::min(r + 1, h - 1);
+        for (int c = c0; c < c1; c++){
+            int left = std::max(c - 1, 0), right = std::min(c + 1, w - 1);
+            float dx = (map[r][right] - map[r][left]) / ((right - left) * spacing);
+            float dz = (map[down][c] - map[up][c]) / ((down - up) * spacing);
+            float length = sqrtf(dx * dx + 1.0f + dz * dz);
+            MeshVertex &v = verts[(size_t)r * w + c];
+            v.normal[0] = -dx / length;
+            v.normal[1] = 1.0f / length;
+            v.normal[2] = -dz / length;
+        }
+    }
+}
+
+void TerrainMesh::markChanged(int first, int last){
+    if (dirtyFirst == dirtyLast){
+        dirtyFirst = first;
+        dirtyLast = last;
+    }
+    else {
+        dirtyFirst = std::min(dirtyFirst, first);
+        dirtyLast = std::max(dirtyLast, last);
+    }
+}
+
+bool writeMeshObj(const char *path, const TerrainMesh &mesh){
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+        return false;
+    const std::vector<MeshVertex> &verts = mesh.vertices();
+    const std::vector<uint32_t> &index = mesh.indices();
+    for (size_t i = 0; i < verts.size(); i++)
+        fprintf(fp, "v %g %g %g\n", verts[i].position[0], verts[i].position[1], verts[i].position[2]);
+    for (size_t i = 0; i < verts.size(); i++)
+        fprintf(fp, "vn %g %g %g\n", verts[i].normal[0], verts[i].normal[1], verts[i].normal[2]);
+    //OBJ counts from 1
+    if (mesh.topology() == MESH_TRIANGLES){
+        for (size_t i = 0; i + 2 < index.size(); i += 3)
+            fprintf(fp, "f %u//%u %u//%u %u//%u\n", index[i] + 1, index[i] + 1,
+                    index[i+1] + 1, index[i+1] + 1, index[i+2] + 1, index[i+2] + 1);
+    }
+    else {
+        //strip triangle k is k, k+1, k+2 with every odd one flipped to keep the winding
+        size_t start = 0;
+        for (size_t i = 0; i <= index.size(); i++){
+            if (i < index.size() && index[i] != MESH_RESTART)
+                continue;
+            for (size_t k = start; k + 2 < i; k++){
+                uint32_t a = index[k], b = index[k+1], c = index[k+2];
+                if ((k - start) % 2)
+                    std::swap(a, b);
+                fprintf(fp, "f %u//%u %u//%u %u//%u\n", a + 1, a + 1, b + 1, b + 1, c + 1, c + 1);
+            }
+            start = i + 1;
+        }
+    }
+    return fclose(fp) == 0;
+}
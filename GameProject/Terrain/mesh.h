@@ -0,0 +1,77 @@
+/*! \file mesh.h
+ * Triangle mesh of a heightmap, built on the CPU with no GL dependency so
+ * the batch programs and exporters can use it too. Vertices are packed
+ * position + normal, one per sample, row major; indices either list two
+ * triangles per cell or run one strip per row of cells with MESH_RESTART
+ * between strips. Either way a cell splits along the same diagonal the
+ * old immediate mode viewers drew.
+ */
+
+#ifndef MESH_H
+#define MESH_H
+
+#include <stdint.h>
+#include <vector>
+#include "heightmap.h"
+
+const uint32_t MESH_RESTART = 0xFFFFFFFFu;     // primitive restart index for strips
+
+enum MeshTopology { MESH_TRIANGLES, MESH_STRIPS };
+
+struct MeshVertex {
+    float position[3];      // x, height, z
+    float normal[3];
+};
+
+class TerrainMesh {
+public:
+    TerrainMesh();
+
+    /**************************************************************************
+     * build: one vertex per sample of map, sample (r, c) at
+     * x = x0 + c * spacing, z = z0 + r * spacing, and the index list for
+     * topology. Marks every vertex changed.
+     **************************************************************************/
+    void build(HeightmapView map, float x0, float z0, float spacing,
+               MeshTopology topology = MESH_TRIANGLES);
+
+    /**************************************************************************
+     * update: map changed in rows r0..r1-1, columns c0..c1-1. Refreshes
+     * those heights and every normal that depends on them; the indices
+     * stay as they are. map must be the size build() saw.
+     **************************************************************************/
+    void update(HeightmapView map, int r0, int c0, int r1, int c1);
+
+    const std::vector<MeshVertex> &vertices() const { return verts; }
+    const std::vector<uint32_t> &indices() const { return index; }
+    MeshTopology topology() const { return shape; }
+    int width() const { return w; }
+    int height() const { return h; }
+
+    /**************************************************************************
+     * changed: the vertices [first, last) changed since clearChanged(),
+     * empty when first == last. A renderer re-uploads just that range.
+     **************************************************************************/
+    void changed(int &first, int &last) const { first = dirtyFirst; last = dirtyLast; }
+    void clearChanged() { dirtyFirst = dirtyLast = 0; }
+
+private:
+    void normals(HeightmapView map, int r0, int c0, int r1, int c1);
+    void markChanged(int first, int last);
+
+    std::vector<MeshVertex> verts;
+    std::vector<uint32_t> index;
+    MeshTopology shape;
+    int w, h;
+    float spacing;
+    int dirtyFirst, dirtyLast;
+};
+
+/******************************************************************************
+ * writeMeshObj: the mesh as a Wavefront OBJ file (v, vn and f lines).
+ * Strips are written as the triangles they stand for. Returns false if
+ * the file could not be written.
+ ******************************************************************************/
+bool writeMeshObj(const char *path, const TerrainMesh &mesh);
+
+#endif
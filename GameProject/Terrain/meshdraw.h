@@ -0,0 +1,101 @@
+/*! \file meshdraw.h
+ * Draws a TerrainMesh from GL buffer objects. Header only so libterrain
+ * stays free of GL; just the viewers include it. The vertices and indices
+ * are uploaded once, a redraw is one glDrawElements, and refresh() sends
+ * only the vertices TerrainMesh::update() touched.
+ *
+ * Buffer objects are GL 1.5, so define GL_GLEXT_PROTOTYPES before the
+ * first GL header or include this file first.
+ */
+
+#ifndef MESHDRAW_H
+#define MESHDRAW_H
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
+
+#include <stddef.h>
+#include <GL/freeglut.h>
+#include "mesh.h"
+
+class MeshBuffers {
+public:
+    MeshBuffers() : vertexBuffer(0), indexBuffer(0), count(0), rowLength(0), shape(MESH_TRIANGLES) {}
+
+    /**************************************************************************
+     * upload: copies the whole mesh into the buffers, making them first if
+     * need be. Needs a current GL context. An empty mesh, one not built yet
+     * or from a map too small for a cell, leaves nothing to draw.
+     **************************************************************************/
+    void upload(TerrainMesh &mesh){
+        if (vertexBuffer == 0){
+            glGenBuffers(1, &vertexBuffer);
+            glGenBuffers(1, &indexBuffer);
+        }
+        const std::vector<MeshVertex> &verts = mesh.vertices();
+        const std::vector<uint32_t> &index = mesh.indices();
+        count = verts.empty() ? 0 : index.size();
+        if (count != 0){
+            glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+            glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(MeshVertex), verts.data(), GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, index.size() * sizeof(uint32_t), index.data(), GL_STATIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+        rowLength = 2 * mesh.width();
+        shape = mesh.topology();
+        mesh.clearChanged();
+    }
+
+    /**************************************************************************
+     * refresh: re-sends the vertices changed since the last upload or
+     * refresh.
+     **************************************************************************/
+    void refresh(TerrainMesh &mesh){
+        int first, last;
+        mesh.changed(first, last);
+        if (first == last || count == 0)
+            return;
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(MeshVertex), (last - first) * sizeof(MeshVertex),
+                        mesh.vertices().data() + first);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        mesh.clearChanged();
+    }
+
+    /**************************************************************************
+     * draw: the mesh in the current colour and polygon mode. Strips are
+     * drawn one row at a time rather than through primitive restart, which
+     * the GL 2.1 contexts we still run on do not have.
+     **************************************************************************/
+    void draw() const {
+        if (count == 0)
+            return;
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glVertexPointer(3, GL_FLOAT, sizeof(MeshVertex), (const GLvoid *)offsetof(MeshVertex, position));
+        glNormalPointer(GL_FLOAT, sizeof(MeshVertex), (const GLvoid *)offsetof(MeshVertex, normal));
+        if (shape == MESH_TRIANGLES)
+            glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (const GLvoid *)0);
+        else
+            for (size_t at = 0; at < count; at += rowLength + 1)
+                glDrawElements(GL_TRIANGLE_STRIP, rowLength, GL_UNSIGNED_INT,
+                               (const GLvoid *)(at * sizeof(uint32_t)));
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+private:
+    GLuint vertexBuffer, indexBuffer;
+    size_t count;           // indices
+    size_t rowLength;       // indices in one strip
+    MeshTopology shape;
+};
+
+#endif
@@ -0,0 +1,186 @@
+/*! \file midpoint.cxx
+ * Midpoint Displacement Algorithm: every square is split into four, the centre
+ * taking the average of the corners and each edge midpoint the average of its
+ * connected points, plus a random displacement that shrinks every level.
+ */
+
+#include "rng.h"
+#include "chunk.h"
+#include "trace.h"
+#include "levels.h"
+#include "midpoint.h"
+
+static constexpr float RANGE = 20.0f;     // maximum displacement of the first level
+
+/******************************************************************************
+ * diamond: computes the average height of the four corners of every square
+ * whose top row is i. range represents the maximum displacement allowed. 
+ ******************************************************************************/
+template <int SIZE, int INCR>
+static void diamond(HeightmapView midpoint, const Rng &level, int i, int step, int range){
+    const int size = fixed<SIZE>(midpoint.width), incr = fixed<INCR>(step), half = incr/2;
+    const float *top = midpoint[i], *bottom = midpoint[i + incr];
+    float *centre = midpoint[i + half];
+    for (int j = 0; j < size-2; j += incr){
+        float total_corners = (top[j]
+                            +  bottom[j]
+                            +  bottom[j + incr]
+                            +  top[j + incr]);
+
+        centre[j+half] = total_corners / 4; 
+        centre[j+half] += level.displacement(range, j+half, i+half);
+    }
+}
+
+/******************************************************************************
+ * edgeAverage: average of the connected points of an edge sample (l, m),
+ * read through border. A point the policy maps back onto (l, m) itself,
+ * as CLAMP does, is left out.
+ ******************************************************************************/
+static float edgeAverage(HeightmapView midpoint, int l, int m, int half, BorderPolicy border){
+    const int size = midpoint.width;
+    const int rows[4] = { l, l, l - half, l + half };
+    const int cols[4] = { m + half, m - half, m, m };
+    float total = 0.0f;
+    int count = 0;
+    for (int k = 0; k < 4; k++){
+        int i = borderIndex(rows[k], size, border), j = borderIndex(cols[k], size, border);
+        if (i != l || j != m){
+            total += midpoint[i][j];
+            count++;
+        }
+    }
+    return total / count;
+}
+
+/******************************************************************************
+ * square: midpoints between the four corners on row l are computed as an
+ * average of connected points, every incr columns. Only the samples on the
+ * edge of the map go through edgeAverage.
+ ******************************************************************************/
+template <int SIZE, int INCR>
+static void square(HeightmapView midpoint, const Rng &level, int l, int step, int range,
+                   BorderPolicy border){
+    const int size = fixed<SIZE>(midpoint.width), incr = fixed<INCR>(step);
+    const int half = incr/2, last = size - 1;
+    float *row = midpoint[l];
+    if (l == 0 || l == last){
+        for (int m = (l + half) % incr; m < size; m += incr)
+            row[m] = edgeAverage(midpoint, l, m, half, border) + level.displacement(range, m, l);
+        return;
+    }
+    const float *up = midpoint[l - half];
+    const float *down = midpoint[l + half];
+    int m = (l + half) % incr;
+    if (m == 0){
+        row[0] = edgeAverage(midpoint, l, 0, half, border) + level.displacement(range, 0, l);
+        m += incr;
+    }
+    for (; m < last; m += incr)
+        row[m] = (row[m + half] + row[m - half] + up[m] + down[m]) / 4 + level.displacement(range, m, l);
+    if (m == last)
+        row[last] = edgeAverage(midpoint, l, last, half, border) + level.displacement(range, last, l);
+}
+
+/******************************************************************************
+ * midpointLevel: the diamonds and squares of the level with the given
+ * step. SIZE and INCR are the grid size and step when they are known at
+ * compile time, 0 when they are not.
+ ******************************************************************************/
+template <int SIZE, int INCR>
+static void midpointLevel(HeightmapView midpoint, const Rng &rng, int step, float range,
+                          BorderPolicy border){
+    TRACE_ZONE("midpoint level");
+    const int size = fixed<SIZE>(midpoint.width), incr = fixed<INCR>(step);
+    const Rng level = rng.stream(incr);
+    for (int i = 0; i < size-2; i += incr)
+        diamond<SIZE, INCR>(midpoint, level, i, incr, range);
+    for (int l = 0; l < size; l += incr/2)
+        square<SIZE, INCR>(midpoint, level, l, incr, range, border);
+}
+
+/******************************************************************************
+ * MidpointLevels: the levels from step INCR down, one instantiation each,
+ * so the level loop is unrolled and every stride is a constant.
+ ******************************************************************************/
+template <int SIZE, int INCR>
+struct MidpointLevels {
+    static void run(HeightmapView midpoint, const Rng &rng, BorderPolicy border){
+        constexpr float range = levelDisplacement(RANGE, gridLevels(SIZE) - gridLevels(INCR + 1));
+        midpointLevel<SIZE, INCR>(midpoint, rng, INCR, range, border);
+        MidpointLevels<SIZE, INCR/2>::run(midpoint, rng, border);
+    }
+};
+
+template <int SIZE>
+struct MidpointLevels<SIZE, 1> {
+    static void run(HeightmapView, const Rng &, BorderPolicy){}
+};
+
+/******************************************************************************
+ * seedCorners: initializing the four corners of the matrix from stream 0
+ * of rng.
+ ******************************************************************************/
+static void seedCorners(HeightmapView midpoint, const Rng &rng){
+    const int size = midpoint.width;
+    const float MIN_Z = -1.0f * (size/2);
+    const Rng corners = rng.stream(0);
+
+    midpoint[0][0] = MIN_Z + corners.displacement(2.0f, 0, 0);
+    midpoint[0][size-1] = MIN_Z + corners.displacement(2.0f, size-1, 0);
+    midpoint[size-1][size-1] = MIN_Z + corners.displacement(2.0f, size-1, size-1);
+    midpoint[size-1][0] = MIN_Z + corners.displacement(2.0f, 0, size-1);
+}
+
+template <int SIZE>
+void midpointDisplacement(HeightmapView midpoint, uint32_t seed, BorderPolicy border) {
+    static_assert(isPowerOfTwoPlusOne(SIZE), "midpointDisplacement needs a 2n+1 grid");
+    requireGrid("midpointDisplacement", midpoint.width, midpoint.height, SIZE);
+    TRACE_ZONE("midpointDisplacement");
+    //stream 0 for the corners, then one stream per level keyed by its step
+    const Rng rng(seed);
+    seedCorners(midpoint, rng);
+    MidpointLevels<SIZE, SIZE - 1>::run(midpoint, rng, border);
+}
+
+template void midpointDisplacement<33>(HeightmapView, uint32_t, BorderPolicy);
+template void midpointDisplacement<65>(HeightmapView, uint32_t, BorderPolicy);
+template void midpointDisplacement<129>(HeightmapView, uint32_t, BorderPolicy);
+template void midpointDisplacement<257>(HeightmapView, uint32_t, BorderPolicy);
+template void midpointDisplacement<513>(HeightmapView, uint32_t, BorderPolicy);
+template void midpointDisplacement<1025>(HeightmapView, uint32_t, BorderPolicy);
+template void midpointDisplacement<2049>(HeightmapView, uint32_t, BorderPolicy);
+template void midpointDisplacement<4097>(HeightmapView, uint32_t, BorderPolicy);
+template void midpointDisplacement<8193>(HeightmapView, uint32_t, BorderPolicy);
+
+typedef void (*MidpointFn)(HeightmapView, uint32_t, BorderPolicy);
+
+//the instantiations above in sizedIndex() order
+static const MidpointFn SIZED[] = {
+    midpointDisplacement<33>, midpointDisplacement<65>, midpointDisplacement<129>,
+    midpointDisplacement<257>, midpointDisplacement<513>, midpointDisplacement<1025>,
+    midpointDisplacement<2049>, midpointDisplacement<4097>, midpointDisplacement<8193>
+};
+static_assert(sizeof(SIZED)/sizeof(SIZED[0]) == SIZED_COUNT, "one instantiation per sized grid");
+
+void midpointDisplacement(HeightmapView midpoint, uint32_t seed, BorderPolicy border) {
+    requireGrid("midpointDisplacement", midpoint.width, midpoint.height, 0);
+    int k = sizedIndex(midpoint.width);
+    if (k >= 0){
+        SIZED[k](midpoint, seed, border);
+        return;
+    }
+    TRACE_ZONE("midpointDisplacement");
+    const Rng rng(seed);
+    seedCorners(midpoint, rng);
+
+    float range = RANGE; //initial max displacement
+    for (int incr = midpoint.width - 1; incr > 1; incr /= 2){
+        midpointLevel<0, 0>(midpoint, rng, incr, range, border);
+        range *= DISPLACEMENT_DECAY;
+    }
+}
+
+void midpointChunk(HeightmapView chunk, uint32_t seed, int x0, int z0){
+    displaceChunk(chunk, Rng(seed).stream(1), x0, z0, RANGE);
+}
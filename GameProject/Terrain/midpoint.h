@@ -0,0 +1,36 @@
+/*! \file midpoint.h
+ * Midpoint Displacement Algorithm.
+ */
+
+#ifndef MIDPOINT_H
+#define MIDPOINT_H
+
+#include <stdint.h>
+#include "heightmap.h"
+
+/******************************************************************************
+ * midpointDisplacement: uses the Midpoint Algorithm to write heightmap values 
+ * to map. It exits with a message unless map is square with a 2n+1
+ * side. The map depends only on seed and border,
+ * which decides what the edge midpoints average past the edge.
+ ******************************************************************************/
+void midpointDisplacement(HeightmapView map, uint32_t seed, BorderPolicy border = BORDER_WRAP);
+
+/******************************************************************************
+ * midpointDisplacement<SIZE>: the same map from code built for a SIZE x SIZE
+ * grid, with the levels unrolled and their strides and ranges constant.
+ * Instantiated for the 2n+1 sizes SIZED_MIN .. SIZED_MAX of levels.h, which
+ * the function above picks for a map of those sizes. Exits if map is not
+ * SIZE x SIZE.
+ ******************************************************************************/
+template <int SIZE>
+void midpointDisplacement(HeightmapView map, uint32_t seed, BorderPolicy border = BORDER_WRAP);
+
+/******************************************************************************
+ * midpointChunk: one chunk of an unbounded Midpoint map whose first sample
+ * sits at world (x0, z0), see displaceChunk() in chunk.h. Its own random
+ * stream and wider range keep it apart from diamondSquareChunk().
+ ******************************************************************************/
+void midpointChunk(HeightmapView chunk, uint32_t seed, int x0, int z0);
+
+#endif
@@ -0,0 +1,28 @@
+/*! \file noiserow.h
+ * Row kernels behind perlinNoise(). Each one sums the octaves for count
+ * consecutive pixels (i0 .. i0+count-1, j) and writes them to out. The SIMD
+ * versions live in noiserow.cxx and must match noiseRowScalar to within
+ * float rounding; perlin.cxx picks one at run time.
+ */
+
+#ifndef NOISEROW_H
+#define NOISEROW_H
+
+#include "cpu.h"
+
+struct NoiseParams {
+    const int *permutation;     // 512 entries, second half repeats the first
+    int octaves;
+    float lastWeight;           // amplitude scale of the last octave, 1 unless faded
+    float freq;                 // frequency of the first octave
+    float gain;                 // amplitude factor per octave
+    float lacunarity;           // frequency factor per octave
+};
+
+typedef void (*NoiseRow)(const NoiseParams &p, int j, int i0, int count, float *out);
+
+void noiseRowScalar(const NoiseParams &p, int j, int i0, int count, float *out);
+void noiseRowSSE(const NoiseParams &p, int j, int i0, int count, float *out);
+void noiseRowAVX2(const NoiseParams &p, int j, int i0, int count, float *out);
+
+#endif
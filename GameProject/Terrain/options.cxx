@@ -0,0 +1,171 @@
+/*! \file options.cxx
+ * Command line handling for the generators.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <getopt.h>
+#include <time.h>
+#include <chrono>
+#include "options.h"
+
+/******************************************************************************
+ * toInt: strict integer conversion, rejects trailing garbage.
+ ******************************************************************************/
+static bool toInt(const char *s, long &value){
+    char *end;
+    value = strtol(s, &end, 10);
+    return *s != '\0' && *end == '\0';
+}
+
+/******************************************************************************
+ * toFloat: strict float conversion, rejects trailing garbage.
+ ******************************************************************************/
+static bool toFloat(const char *s, float &value){
+    char *end;
+    value = strtof(s, &end);
+    return *s != '\0' && *end == '\0';
+}
+
+bool parseOptions(int argc, char *argv[], Options &opts){
+    static struct option longopts[] = {
+        { "size",       required_argument, NULL, 's' },
+        { "seed",       required_argument, NULL, 'r' },
+        { "iterations", required_argument, NULL, 'n' },
+        { "output",     required_argument, NULL, 'o' },
+        { "times",      required_argument, NULL, 't' },
+        { "threads",    required_argument, NULL, 'j' },
+        { "band",       required_argument, NULL, 'b' },
+        { "method",     required_argument, NULL, 'm' },
+        { "tolerance",  required_argument, NULL, 'e' },
+        { "levels",     required_argument, NULL, 'l' },
+        { "border",     required_argument, NULL, 'B' },
+        { "help",       no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    long value;
+    float real;
+    int ch;
+
+    optind = 1;
+    while ((ch = getopt_long(argc, argv, "s:r:n:o:t:j:b:m:e:l:B:h", longopts, NULL)) != -1){
+        switch(ch)
+        {
+            case 's': {
+                if (!toInt(optarg, value) || value < 2)
+                    return false;
+                opts.size = value;
+                break;
+            }
+            case 'r': {
+                if (!toInt(optarg, value))
+                    return false;
+                opts.seed = (unsigned int)value;
+                break;
+            }
+            case 'n': {
+                if (!toInt(optarg, value) || value < 0)
+                    return false;
+                opts.iterations = value;
+                break;
+            }
+            case 'o': {
+                opts.output = optarg;
+                break;
+            }
+            case 't': {
+                opts.times = optarg;
+                break;
+            }
+            case 'j': {
+                if (!toInt(optarg, value) || value < 0)
+                    return false;
+                opts.threads = value;
+                break;
+            }
+            case 'b': {
+                if (!toInt(optarg, value) || value < 0 || value > 2)
+                    return false;
+                opts.band = value;
+                break;
+            }
+            case 'm': {
+                opts.method = optarg;
+                break;
+            }
+            case 'e': {
+                if (!toFloat(optarg, real) || !(real >= 0.0f))
+                    return false;
+                opts.tolerance = real;
+                break;
+            }
+            case 'l': {
+                if (!toInt(optarg, value) || value < 0)
+                    return false;
+                opts.levels = value;
+                break;
+            }
+            case 'B': {
+                if (!borderPolicyByName(optarg, opts.border))
+                    return false;
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return optind == argc;
+}
+
+void usage(const char *prog, const Options &opts){
+    fprintf(stderr, "usage: %s [options]\n", prog);
+    fprintf(stderr, "  -s, --size N        grid points per side (default %d)\n", opts.size);
+    fprintf(stderr, "  -r, --seed N        random seed (default: current time)\n");
+    fprintf(stderr, "  -n, --iterations N  faults, particles, octaves, erosion or camera steps\n"
+                    "                      (default %d)\n",
+            opts.iterations);
+    fprintf(stderr, "  -o, --output FILE   write the heightmap to FILE: tiled float32 for .tmap,\n"
+                    "                      tiled uint16 for .tmap16, a mesh for .obj, else raw\n"
+                    "                      floats\n");
+    fprintf(stderr, "  -t, --times FILE    append the generation time to FILE\n");
+    fprintf(stderr, "  -j, --threads N     worker threads, 0 for one per core (default %d)\n",
+            opts.threads);
+    fprintf(stderr, "  -b, --band N        perlin octaves: 0 all, 1 up to nyquist, 2 nyquist\n"
+                    "                      with the top octave faded (default %d)\n", opts.band);
+    fprintf(stderr, "  -m, --method NAME   fault: rows, brute or tiled (default rows)\n"
+                    "                      particle: single or walkers (default single)\n"
+                    "                      erosion: dense, sparse or multigrid (default dense)\n"
+                    "                      chunks: perlin, diamond or midpoint (default perlin)\n"
+                    "                      codec, lod, tin: diamond, midpoint, fault, particle or\n"
+                    "                      perlin (default diamond)\n");
+    fprintf(stderr, "  -e, --tolerance X   sparse erosion: distance from settled water that\n"
+                    "                      keeps a cell active; codec: largest height error;\n"
+                    "                      lod: largest screen error in pixels; tin: largest\n"
+                    "                      vertical error (default %g)\n",
+            opts.tolerance);
+    fprintf(stderr, "  -l, --levels N      multigrid erosion: coarse levels under the map;\n"
+                    "                      lod: cells along a node's side (default %d)\n", opts.levels);
+    fprintf(stderr, "  -B, --border NAME   past the edge of the map: wrap, clamp or mirror\n"
+                    "                      (default %s)\n", borderPolicyName(opts.border));
+}
+
+void appendTime(const char *path, float seconds){
+    FILE *fp = fopen(path, "a+");//open for writing
+    if (fp == NULL){
+        perror(path);
+        return;
+    }
+    fprintf(fp, "%f\n", seconds);
+    fclose(fp);//closing the file
+}
+
+double wallClock(){
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double cpuClock(){
+    struct timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
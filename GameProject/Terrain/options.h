@@ -0,0 +1,58 @@
+/*! \file options.h
+ * Command line options shared by the viewers and the headless batch programs.
+ * Every generator understands the same switches so a run can be scripted
+ * without recompiling for a new map size or seed.
+ */
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include "heightmap.h"
+#include "levels.h"
+
+struct Options {
+    int size;               // grid points per side
+    unsigned int seed;      // value handed to the random generator
+    int iterations;         // faults, particles, octaves, erosion or camera steps
+    const char *output;     // heightmap file to write, NULL for none
+    const char *times;      // file the generation time is appended to
+    int threads;            // worker threads, 0 for one per core
+    int band;               // perlin octave band: 0 all, 1 nyquist, 2 nyquist with fade
+    const char *method;     // generator specific variant, NULL for its default
+    float tolerance;        // sparse erosion: distance from settled water that keeps a cell
+                            // active; codec, tin: largest height error; lod: screen error
+    int levels;             // multigrid erosion: coarse levels under the map
+    BorderPolicy border;    // what the stencils read past the edge of the map
+};
+
+/******************************************************************************
+ * parseOptions: reads -s/--size, -r/--seed, -n/--iterations, -o/--output,
+ * -t/--times, -j/--threads, -b/--band, -m/--method, -e/--tolerance,
+ * -l/--levels and -B/--border into opts. Anything not given keeps the value
+ * already in opts. Returns false on an unknown switch or a malformed value.
+ ******************************************************************************/
+bool parseOptions(int argc, char *argv[], Options &opts);
+
+/******************************************************************************
+ * usage: prints the switches and the defaults in opts to stderr.
+ ******************************************************************************/
+void usage(const char *prog, const Options &opts);
+
+/******************************************************************************
+ * wallClock: seconds since an arbitrary start. clock() adds up the time of
+ * every thread, so it overstates anything that runs on the pool.
+ ******************************************************************************/
+double wallClock();
+
+/******************************************************************************
+ * cpuClock: CPU seconds used so far by every thread of the process.
+ ******************************************************************************/
+double cpuClock();
+
+/******************************************************************************
+ * appendTime: appends one timing line to path, same format as the old .txt
+ * files so average.py keeps working.
+ ******************************************************************************/
+void appendTime(const char *path, float seconds);
+
+#endif
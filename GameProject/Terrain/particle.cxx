@@ -0,0 +1,160 @@
+/*! \file particle.cxx
+ * Particle Deposition Algorithm.
+ */
+
+#include <string.h>
+#include <algorithm>
+#include "rng.h"
+#include "trace.h"
+#include "particle.h"
+
+const int PARTICLE_TILE = 64;      // walker region side in the multi-walker mode
+const int PARTICLE_BATCH = 1024;   // particles each walker drops per round
+
+/******************************************************************************
+ * Region: the rows [r0, r1) and columns [c0, c1) a walker and the particles
+ * it drops stay inside. The whole map in the single walker mode.
+ ******************************************************************************/
+struct Region {
+    int r0, r1, c0, c1;
+};
+
+/******************************************************************************
+ * settle: rolls a particle dropped on (i, j) downhill and deposits it where
+ * no diagonal neighbour inside region is lower. Every step goes strictly
+ * down, so the loop ends; it used to recurse once per step. When several
+ * neighbours are lower the one the old 3x3 scan saw last is taken.
+ ******************************************************************************/
+static void settle(HeightmapView particle, const Region &region, int i, int j){
+    static const int dr[4] = { 1, 1, -1, -1 };
+    static const int dc[4] = { 1, -1, 1, -1 };
+    for (;;){
+        const float h = particle[i][j];
+        int k = 0;
+        for (; k < 4; k++){
+            int r = i + dr[k];
+            int c = j + dc[k];
+            if (r >= region.r0 && r < region.r1 && c >= region.c0 && c < region.c1
+                && particle[r][c] < h)
+                break;
+        }
+        if (k == 4){
+            particle[i][j] += 1.5f;
+            return;
+        }
+        i += dr[k];
+        j += dc[k];
+    }
+}
+
+/******************************************************************************
+ * wander: moves the drop point (w1, w2) one cell in the direction picked by
+ * bits, wrapping around inside region.
+ ******************************************************************************/
+static void wander(uint32_t bits, const Region &region, int &w1, int &w2){
+    int wall = bits%4;
+    switch(wall)
+    {
+        case 0: {
+            w2--;
+            if(w2 < region.c0)
+                w2 = region.c1 - 1;
+            break;
+        }
+        case 1: {
+            w2++;
+            if(w2 >= region.c1)
+                w2 = region.c0;
+            break;
+        }
+        case 2: {
+            w1++;
+            if(w1 >= region.r1)
+                w1 = region.r0;
+            break;
+        }
+        case 3: {
+            w1--;
+            if(w1 < region.r0)
+                w1 = region.r1 - 1;
+            break;
+        }
+    }
+}
+
+/******************************************************************************
+ * singleWalker: the original algorithm, one drop point wandering over the
+ * whole map.
+ ******************************************************************************/
+static void singleWalker(HeightmapView particle, const Rng &rng, int particles){
+    const int size = particle.width;
+    //stream 0 for the drop point, stream 1 for the step taken before particle i
+    const Rng steps = rng.stream(1);
+    const Region map = { 0, size, 0, size };
+    int w1 = rng.stream(0).bits(0)%size;
+    int w2 = rng.stream(0).bits(1)%size;
+    for (int i = 0; i < particles; i++){
+        wander(steps.bits(i), map, w1, w2);
+        settle(particle, map, w1, w2);
+    }
+}
+
+/******************************************************************************
+ * multiWalker: one walker per PARTICLE_TILE square, all dropping at once.
+ * A walker's particles only roll inside its own square, so squares can run
+ * on any thread in any order and the map depends only on seed. The squares
+ * shift by half a tile every round so their borders do not show up as
+ * ridges.
+ ******************************************************************************/
+static void multiWalker(HeightmapView particle, const Rng &rng, int particles, ThreadPool *pool){
+    const int size = particle.width;
+    //stream 2 for each walker's start, stream 3 for its steps; the round is
+    //the second counter of both
+    const Rng starts = rng.stream(2);
+    const Rng steps = rng.stream(3);
+    int done = 0;
+    for (int round = 0; done < particles; round++){
+        const int offset = (round % 2) * (PARTICLE_TILE / 2);
+        const int side = (size + offset + PARTICLE_TILE - 1) / PARTICLE_TILE;
+        const int tiles = side * side;
+        const int quota = std::min(particles - done, tiles * PARTICLE_BATCH);
+        parallelFor(pool, 0, tiles, [&](int first, int last){
+            TRACE_ZONE("particle tiles");
+            for (int k = first; k < last; k++){
+                Region region;
+                region.r0 = std::max((k / side) * PARTICLE_TILE - offset, 0);
+                region.r1 = std::min((k / side + 1) * PARTICLE_TILE - offset, size);
+                region.c0 = std::max((k % side) * PARTICLE_TILE - offset, 0);
+                region.c1 = std::min((k % side + 1) * PARTICLE_TILE - offset, size);
+                int w1 = region.r0 + starts.bits(2 * k, round) % (region.r1 - region.r0);
+                int w2 = region.c0 + starts.bits(2 * k + 1, round) % (region.c1 - region.c0);
+                int count = quota / tiles + (k < quota % tiles);
+                for (int i = 0; i < count; i++){
+                    wander(steps.bits(k * PARTICLE_BATCH + i, round), region, w1, w2);
+                    settle(particle, region, w1, w2);
+                }
+            }
+        });
+        done += quota;
+    }
+}
+
+void particleDeposition(HeightmapView particle, uint32_t seed, int particles,
+                        ParticleMethod method, ThreadPool *pool) {
+    TRACE_ZONE("particleDeposition");
+    const Rng rng(seed);
+    if (method == PARTICLE_WALKERS)
+        multiWalker(particle, rng, particles, pool);
+    else
+        singleWalker(particle, rng, particles);
+}
+
+bool particleMethodByName(const char *name, ParticleMethod &method){
+    static const char *names[] = { "single", "walkers" };
+    for (int i = 0; i < 2; i++)
+        if (strcmp(name, names[i]) == 0){
+            method = (ParticleMethod)i;
+            return true;
+        }
+    return false;
+}
@@ -0,0 +1,38 @@
+/*! \file particle.h
+ * Particle Deposition Algorithm.
+ */
+
+#ifndef PARTICLE_H
+#define PARTICLE_H
+
+#include <stdint.h>
+#include "heightmap.h"
+#include "threadpool.h"
+
+/******************************************************************************
+ * ParticleMethod: SINGLE is the original algorithm, one drop point for the
+ * whole map. WALKERS drops from one point per 64x64 region at once and lets
+ * particles roll only inside their region, for very large particle counts.
+ ******************************************************************************/
+enum ParticleMethod {
+    PARTICLE_SINGLE,
+    PARTICLE_WALKERS
+};
+
+/******************************************************************************
+ * particleDeposition: uses the Particle Deposition Algorithm to write 
+ * heightmap values to map. The drop point wanders one step per particle and
+ * every particle rolls downhill before it settles. The map depends only on
+ * seed and method: WALKERS splits its regions across pool and gives the same
+ * result for any number of threads.
+ ******************************************************************************/
+void particleDeposition(HeightmapView map, uint32_t seed, int particles,
+                        ParticleMethod method = PARTICLE_SINGLE, ThreadPool *pool = NULL);
+
+/******************************************************************************
+ * particleMethodByName: "single" or "walkers" for --method. False for
+ * anything else.
+ ******************************************************************************/
+bool particleMethodByName(const char *name, ParticleMethod &method);
+
+#endif
@@ -0,0 +1,228 @@
+/*! \file perlin.cxx
+ * Perlin Noise Algorithm.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include "rng.h"
+#include "noiserow.h"
+#include "perlin.h"
+#include "trace.h"
+
+static float gradients[8][2] = 
+{
+  { -1.0f, -1.0f }, { 1.0f, 0.0f } , { -1.0f, 0.0f } , { 1.0f, 1.0f } ,
+  { -1.0f, 1.0f } , { 0.0f, -1.0f } , { 0.0f, 1.0f } , { 1.0f, -1.0f }
+};
+
+static float dot(float grad[], float x, float y)
+{
+    return (grad[0] * x + grad[1] * y);
+}
+
+static float lerp(float t, float a, float b) 
+{ 
+    return a + t * (b - a); 
+}
+
+/******************************************************************************
+ * permute: set up random numbers table, one per map so several can be
+ * generated at once.
+ ******************************************************************************/
+static void permute(const Rng &rng, int permutation[512]){ 
+    for (int i = 0; i < 256; i++)
+        permutation[256+i] = permutation[i] = (int)rng.displacement(256, i);
+}
+
+/******************************************************************************
+ * noise: 2D noise. for each pixel coordindate (i, j) calculate the 
+ * dot product of the distance and gradient vectors. Interpolate these noise values
+ ******************************************************************************/
+static float noise(const int permutation[512], int i, int j, float freq){
+    int x    = floor(j * freq);
+    int y    = floor(i * freq);
+
+    //fractional grid points
+    float fx = (j * freq) - x;
+    float fy = (i * freq) - y;
+    
+    //indexing into the gradients for the four nearby points
+    int g1   = permutation[(x + permutation[y & 255]) & 255] & 7;
+    int g2   = permutation[(x + 1 + permutation[y & 255]) & 255] & 7;
+    int g3   = permutation[(x + permutation[(y + 1) & 255]) & 255] & 7;
+    int g4   = permutation[(x + 1 + permutation[(y + 1) & 255]) & 255] & 7;//
+    
+    //dot products that get the noise from each corner.
+    float n1 = dot(gradients[g1], fx, fy);
+    float n2 = dot(gradients[g2], fx - 1.0f, fy);
+    float n3 = dot(gradients[g3], fx, fy - 1.0f);
+    float n4 = dot(gradients[g4], fx - 1.0f, fy - 1.0f);
+
+    //fade value calculated by Ken Perlin
+    float sx = fx * fx * fx * (fx * ( 6 * fx - 15) + 10);
+    float sy = fx * fx * fx * (fx * ( 6 * fy - 15) + 10);
+
+    //interpolation along x axis
+    float i1 = lerp(n1, n2, sx);
+    float i2 = lerp(n3, n4, sx);
+
+    return lerp(i1, i2, sy);
+}
+
+/******************************************************************************
+ * noiseRowScalar: one noise() call per pixel and octave. The reference the 
+ * SIMD kernels are checked against.
+ ******************************************************************************/
+void noiseRowScalar(const NoiseParams &p, int j, int i0, int count, float *out){
+    float amp, freq, pix;
+    for (int i = i0; i < i0 + count; i++)
+    {
+        amp = 1.0f;
+        freq = p.freq;
+        pix = 0.0f;
+        for (int k = 0; k < p.octaves; ++k)
+        {
+            float lerped = noise(p.permutation, i, j, freq);
+            float a = k == p.octaves - 1 ? amp * p.lastWeight : amp;
+            pix += lerped * a;
+            amp *= p.gain;
+            freq *= p.lacunarity;
+        }
+        out[i - i0] = pix;
+    }
+}
+
+/******************************************************************************
+ * pickKernel: the widest kernel this machine runs, or the one asked for.
+ ******************************************************************************/
+static NoiseRow pickKernel(NoisePath path){
+    if (path == NOISE_AUTO)
+        path = bestNoisePath();
+    switch(path)
+    {
+        case NOISE_AVX2:
+            return cpuHasAVX2() ? noiseRowAVX2 : noiseRowScalar;
+        case NOISE_SSE:
+            return cpuHasSSE() ? noiseRowSSE : noiseRowScalar;
+        default:
+            return noiseRowScalar;
+    }
+}
+
+NoisePath bestNoisePath(){
+    if (cpuHasAVX2())
+        return NOISE_AVX2;
+    if (cpuHasSSE())
+        return NOISE_SSE;
+    return NOISE_SCALAR;
+}
+
+const char *noisePathName(NoisePath path){
+    switch(path)
+    {
+        case NOISE_SCALAR: return "scalar";
+        case NOISE_SSE:    return "sse4.1";
+        case NOISE_AVX2:   return "avx2";
+        default:           return "auto";
+    }
+}
+
+OctaveBand bandLimit(int octaves, float freq, float lacunarity, BandMode mode){
+    OctaveBand band;
+    band.requested = octaves;
+    band.octaves = octaves;
+    band.lastWeight = 1.0f;
+    if (mode == BAND_ALL)
+        return band;
+
+    //keep every octave whose frequency is at or under the limit
+    int kept = 0;
+    float f = freq;
+    while (kept < octaves && f <= NYQUIST_LIMIT){
+        kept++;
+        f *= lacunarity;
+    }
+    band.octaves = kept;
+
+    //fade the top octave in over its last lacunarity step below the limit
+    //so the cutoff does not jump when the map size changes
+    if (mode == BAND_NYQUIST_FADE && kept > 0){
+        float top = f / lacunarity;
+        float w = (NYQUIST_LIMIT - top) / (NYQUIST_LIMIT - NYQUIST_LIMIT / lacunarity);
+        band.lastWeight = w < 0.0f ? 0.0f : w > 1.0f ? 1.0f : w;
+    }
+    return band;
+}
+
+void printOctaveBand(const OctaveBand &band){
+    if (band.octaves == band.requested)
+        fprintf(stderr, "octaves: all %d kept", band.requested);
+    else if (band.octaves + 1 == band.requested)
+        fprintf(stderr, "octaves: %d of %d kept, skipped %d", band.octaves, band.requested,
+                band.octaves);
+    else
+        fprintf(stderr, "octaves: %d of %d kept, skipped %d-%d", band.octaves, band.requested,
+                band.octaves, band.requested - 1);
+    if (band.lastWeight < 1.0f)
+        fprintf(stderr, ", octave %d faded to %.3f", band.octaves - 1, band.lastWeight);
+    fprintf(stderr, "\n");
+}
+
+void perlinNoise(HeightmapView perlin, uint32_t seed, int octaves, NoisePath path,
+                 BandMode mode, OctaveBand *used) {
+    TRACE_ZONE("perlinNoise");
+    const int size = perlin.width;
+    const float MIN_Z = -1.0f * (size/2);
+    int permutation[512]; //random number array
+    //stream 0 for the corners, stream 1 for the permutation table
+    const Rng rng(seed);
+    const Rng corners = rng.stream(0);
+
+    permute(rng.stream(1), permutation);
+    //initializes the four corners of the map
+    perlin[0][0] = MIN_Z + corners.displacement(1.0f, 0, 0);
+    perlin[0][size-1] = MIN_Z + corners.displacement(1.0f, size-1, 0);
+    perlin[size-1][0] = MIN_Z + corners.displacement(1.0f, 0, size-1);
+    perlin[size-1][size-1] = MIN_Z + corners.displacement(1.0f, size-1, size-1);
+
+    NoiseParams p;
+    p.permutation = permutation;
+    p.freq = 1.0f / (float)size;
+    p.gain = 0.65f;
+    p.lacunarity = 2.5f;
+    OctaveBand band = bandLimit(octaves, p.freq, p.lacunarity, mode);
+    p.octaves = band.octaves;
+    p.lastWeight = band.lastWeight;
+    if (used != NULL)
+        *used = band;
+    NoiseRow row = pickKernel(path);
+    TRACE_COUNTER("perlin octaves", p.octaves);
+
+    //perlin[j][i] holds the noise at (i, j), so a row of the map is a run of
+    //consecutive i and the kernels can store whole vectors
+    for (int j = 0; j < size; j++)
+        row(p, j, 0, size, perlin[j]);
+}
+
+void perlinChunk(HeightmapView chunk, uint32_t seed, int octaves, int x0, int z0){
+    const int size = chunk.width;
+    int permutation[512];
+    const Rng rng(seed);
+
+    permute(rng.stream(1), permutation);
+    NoiseParams p;
+    p.permutation = permutation;
+    p.freq = 1.0f / (float)(size - 1);
+    p.gain = 0.65f;
+    p.lacunarity = 2.5f;
+    p.octaves = octaves;
+    p.lastWeight = 1.0f;
+    NoiseRow row = pickKernel(NOISE_AUTO);
+
+    for (int j = 0; j < size; j++){
+        float *out = chunk[j];
+        noiseRowScalar(p, z0 + j, x0, 1, out);
+        row(p, z0 + j, x0 + 1, size - 2, out + 1);
+        noiseRowScalar(p, z0 + j, x0 + size - 1, 1, out + size - 1);
+    }
+}
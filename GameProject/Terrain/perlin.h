@@ -0,0 +1,71 @@
+/*! \file perlin.h
+ * Perlin Noise Algorithm.
+ */
+
+#ifndef PERLIN_H
+#define PERLIN_H
+
+#include <stdint.h>
+#include "heightmap.h"
+
+/******************************************************************************
+ * NoisePath: which inner loop perlinNoise() runs. AUTO takes the widest the
+ * CPU supports; asking for one the CPU lacks falls back to SCALAR.
+ ******************************************************************************/
+enum NoisePath { NOISE_AUTO, NOISE_SCALAR, NOISE_SSE, NOISE_AVX2 };
+
+/******************************************************************************
+ * BandMode: which octaves perlinNoise() sums. Octaves above NYQUIST_LIMIT
+ * (in lattice cells per map cell) only alias, so the band limited modes skip
+ * them; FADE also scales the top kept octave down as it nears the limit.
+ ******************************************************************************/
+enum BandMode { BAND_ALL, BAND_NYQUIST, BAND_NYQUIST_FADE };
+
+const float NYQUIST_LIMIT = 0.5f;
+
+/******************************************************************************
+ * OctaveBand: the octaves a band mode kept. Octaves octaves .. requested-1
+ * were skipped.
+ ******************************************************************************/
+struct OctaveBand {
+    int requested;
+    int octaves;            // octaves summed, the first ones
+    float lastWeight;       // amplitude scale of the last summed octave
+};
+
+/******************************************************************************
+ * bandLimit: the octaves mode keeps out of octaves, starting at freq and
+ * multiplying by lacunarity each octave.
+ ******************************************************************************/
+OctaveBand bandLimit(int octaves, float freq, float lacunarity, BandMode mode);
+
+/******************************************************************************
+ * printOctaveBand: reports the skipped octaves and the fade weight to stderr.
+ ******************************************************************************/
+void printOctaveBand(const OctaveBand &band);
+
+/******************************************************************************
+ * perlinNoise: uses the perlin Algorithm to write heightmap values to map,
+ * summing octaves of gradient noise. The map depends only on seed; the SIMD
+ * paths agree with the scalar one to within float rounding. If used is not
+ * NULL it receives the octaves the band mode kept.
+ ******************************************************************************/
+void perlinNoise(HeightmapView map, uint32_t seed, int octaves, NoisePath path = NOISE_AUTO,
+                 BandMode mode = BAND_ALL, OctaveBand *used = NULL);
+
+/******************************************************************************
+ * perlinChunk: the same octaves sampled at world (x0 + col, z0 + row), with
+ * one lattice cell per chunk side, so the chunks of one seed join into a
+ * single unbounded map. The first and last columns always take the scalar
+ * kernel: a neighbour computes them too and must get the same bits.
+ ******************************************************************************/
+void perlinChunk(HeightmapView chunk, uint32_t seed, int octaves, int x0, int z0);
+
+/******************************************************************************
+ * bestNoisePath: the path NOISE_AUTO resolves to on this machine.
+ ******************************************************************************/
+NoisePath bestNoisePath();
+
+const char *noisePathName(NoisePath path);
+
+#endif
@@ -0,0 +1,65 @@
+/*! \file rng.h
+ * Counter based random numbers. Instead of stepping a hidden state like
+ * rand(), every value is a hash of a key (seed and stream) and a counter
+ * (usually the x, y of the cell being displaced). Any cell can be computed
+ * on its own, in any order, on any thread, and the loops over x vectorize
+ * since the hash is plain 32 bit integer arithmetic.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/******************************************************************************
+ * hash32: 32 bit integer finalizer ("lowbias32" from Chris Wellons' hash
+ * prospector). A bijection, so distinct counters never collide for a key.
+ ******************************************************************************/
+inline uint32_t hash32(uint32_t x){
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+class Rng {
+public:
+    explicit Rng(uint32_t seed) : key(hash32(seed ^ 0x9e3779b9U)) {}
+
+    /**************************************************************************
+     * stream: an independent generator for one purpose, e.g. one per level
+     * of a midpoint generator, so (level, x, y) never repeats a value.
+     **************************************************************************/
+    Rng stream(uint32_t s) const { return Rng(key, hash32(s + 0x632be5abU)); }
+
+    /**************************************************************************
+     * bits: 32 random bits for the counter (x, y).
+     **************************************************************************/
+    uint32_t bits(uint32_t x, uint32_t y = 0) const {
+        return hash32(x ^ hash32(y ^ key));
+    }
+
+    /**************************************************************************
+     * uniform: random float in [0, 1) from the top 24 bits.
+     **************************************************************************/
+    float uniform(uint32_t x, uint32_t y = 0) const {
+        return (float)(bits(x, y) >> 8) * (1.0f / 16777216.0f);
+    }
+
+    /**************************************************************************
+     * displacement: random value between -max/2 and max/2, the range the old
+     * random(float max) helper returned.
+     **************************************************************************/
+    float displacement(float max, uint32_t x, uint32_t y = 0) const {
+        return uniform(x, y) * max - (max * 0.5f);
+    }
+
+private:
+    Rng(uint32_t parent, uint32_t s) : key(hash32(parent ^ s)) {}
+
+    uint32_t key;
+};
+
+#endif
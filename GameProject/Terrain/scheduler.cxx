@@ -0,0 +1,242 @@
+/*! \file scheduler.cxx
+ * Background chunk generation.
+ */
+
+#include "scheduler.h"
+
+ChunkScheduler::ChunkScheduler(ChunkCache &cache, int threads)
+    : cache(cache), busy(0), stamp(0), made(0), joined(0), dropped(0), quit(false) {
+    if (threads <= 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads <= 0)
+        threads = 1;
+    for (int i = 0; i < threads; i++)
+        workers.push_back(std::thread(&ChunkScheduler::work, this));
+}
+
+ChunkScheduler::~ChunkScheduler(){
+    std::vector<Finished> gone;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        quit = true;
+        for (Tasks::iterator t = tasks.begin(); t != tasks.end(); ++t)
+            if (!t->second.running)
+                gone.push_back(take(t->first, t->second));
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    for (size_t i = 0; i < gone.size(); i++)
+        deliver(gone[i], Chunk());
+}
+
+uint64_t ChunkScheduler::keyOf(int cx, int cz){
+    return (uint64_t)(uint32_t)cx << 32 | (uint32_t)cz;
+}
+
+void ChunkScheduler::chunkOf(uint64_t key, int &cx, int &cz){
+    cx = (int)(uint32_t)(key >> 32);
+    cz = (int)(uint32_t)key;
+}
+
+/******************************************************************************
+ * enqueue: (re)queues task at priority. Older queue entries for it keep
+ * their version and are skipped when they come up. Caller holds lock.
+ ******************************************************************************/
+void ChunkScheduler::enqueue(uint64_t key, Task &task, float priority){
+    task.priority = priority;
+    task.version = ++stamp;
+    Queued entry = { priority, task.version, key };
+    queue.push(entry);
+}
+
+/******************************************************************************
+ * take: moves what is needed to answer task's requesters out of it. The
+ * caller erases the task and delivers once the lock is released.
+ ******************************************************************************/
+ChunkScheduler::Finished ChunkScheduler::take(uint64_t key, Task &task){
+    Finished finished;
+    chunkOf(key, finished.cx, finished.cz);
+    finished.promise = std::move(task.promise);
+    finished.done.swap(task.done);
+    return finished;
+}
+
+void ChunkScheduler::deliver(Finished &finished, Chunk chunk){
+    finished.promise.set_value(chunk);
+    for (size_t i = 0; i < finished.done.size(); i++)
+        finished.done[i](finished.cx, finished.cz, chunk);
+}
+
+ChunkScheduler::Future ChunkScheduler::request(int cx, int cz, float priority, const ChunkDone &done){
+    const uint64_t key = keyOf(cx, cz);
+    std::unique_lock<std::mutex> guard(lock);
+    Tasks::iterator found = tasks.find(key);
+    if (found != tasks.end()){
+        Task &task = found->second;
+        joined++;
+        if (done)
+            task.done.push_back(done);
+        if (!task.running && priority < task.priority)
+            enqueue(key, task, priority);
+        return task.future;
+    }
+
+    Chunk chunk = cache.find(cx, cz);
+    if (chunk){
+        guard.unlock();
+        std::promise<Chunk> ready;
+        ready.set_value(chunk);
+        if (done)
+            done(cx, cz, chunk);
+        return ready.get_future().share();
+    }
+
+    Task &task = tasks[key];
+    task.running = false;
+    task.future = task.promise.get_future().share();
+    if (done)
+        task.done.push_back(done);
+    enqueue(key, task, priority);
+    Future future = task.future;
+    guard.unlock();
+    wake.notify_one();
+    return future;
+}
+
+std::vector<ChunkScheduler::Future> ChunkScheduler::requestRegion(int cx0, int cz0, int cx1, int cz1,
+                                                                  const ChunkPriority &priority,
+                                                                  const ChunkDone &done){
+    std::vector<Future> futures;
+    for (int cz = cz0; cz <= cz1; cz++)
+        for (int cx = cx0; cx <= cx1; cx++)
+            futures.push_back(request(cx, cz, priority(cx, cz), done));
+    return futures;
+}
+
+bool ChunkScheduler::reprioritize(int cx, int cz, float priority){
+    const uint64_t key = keyOf(cx, cz);
+    std::lock_guard<std::mutex> guard(lock);
+    Tasks::iterator found = tasks.find(key);
+    if (found == tasks.end() || found->second.running)
+        return false;
+    enqueue(key, found->second, priority);
+    return true;
+}
+
+int ChunkScheduler::retarget(const ChunkPriority &priority, float cutoff){
+    std::vector<Finished> gone;
+    bool empty;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        //every queued task gets a new entry, so start the heap afresh
+        //rather than leaving a stale entry per task behind
+        queue = std::priority_queue<Queued>();
+        for (Tasks::iterator t = tasks.begin(); t != tasks.end();){
+            Task &task = t->second;
+            int cx, cz;
+            chunkOf(t->first, cx, cz);
+            float p = task.running ? 0.0f : priority(cx, cz);
+            if (!task.running && p > cutoff){
+                gone.push_back(take(t->first, task));
+                t = tasks.erase(t);
+                continue;
+            }
+            if (!task.running)
+                enqueue(t->first, task, p);
+            ++t;
+        }
+        dropped += gone.size();
+        empty = tasks.empty() && busy == 0;
+    }
+    for (size_t i = 0; i < gone.size(); i++)
+        deliver(gone[i], Chunk());
+    if (empty)
+        idle.notify_all();
+    return (int)gone.size();
+}
+
+bool ChunkScheduler::cancel(int cx, int cz){
+    const uint64_t key = keyOf(cx, cz);
+    Finished gone;
+    bool empty;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        Tasks::iterator found = tasks.find(key);
+        if (found == tasks.end() || found->second.running)
+            return false;
+        gone = take(key, found->second);
+        tasks.erase(found);
+        dropped++;
+        empty = tasks.empty() && busy == 0;
+    }
+    deliver(gone, Chunk());
+    if (empty)
+        idle.notify_all();
+    return true;
+}
+
+void ChunkScheduler::drain(){
+    std::unique_lock<std::mutex> guard(lock);
+    idle.wait(guard, [this]{ return tasks.empty() && busy == 0; });
+}
+
+size_t ChunkScheduler::pending() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return tasks.size();
+}
+
+unsigned long ChunkScheduler::generated() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return made;
+}
+
+unsigned long ChunkScheduler::coalesced() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return joined;
+}
+
+unsigned long ChunkScheduler::cancelled() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return dropped;
+}
+
+/******************************************************************************
+ * work: worker thread loop. Takes the lowest priority queued chunk,
+ * generates it without the lock and answers everyone who asked for it,
+ * including requests that joined while it ran.
+ ******************************************************************************/
+void ChunkScheduler::work(){
+    const ChunkSource &source = cache.source();
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;){
+        wake.wait(guard, [this]{ return quit || !queue.empty(); });
+        if (quit)
+            return;
+        Queued top = queue.top();
+        queue.pop();
+        Tasks::iterator found = tasks.find(top.key);
+        if (found == tasks.end() || found->second.running || found->second.version != top.version)
+            continue;
+        found->second.running = true;
+        busy++;
+        guard.unlock();
+
+        int cx, cz;
+        chunkOf(top.key, cx, cz);
+        std::shared_ptr<Heightmap> fresh = std::make_shared<Heightmap>(source.size());
+        source.generate(cx, cz, fresh->view());
+        Chunk chunk = cache.put(cx, cz, fresh);
+
+        guard.lock();
+        found = tasks.find(top.key);
+        Finished finished = take(top.key, found->second);
+        tasks.erase(found);
+        made++;
+        guard.unlock();
+        deliver(finished, chunk);
+        guard.lock();
+        if (--busy == 0 && tasks.empty())
+            idle.notify_all();
+    }
+}
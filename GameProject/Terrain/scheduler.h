@@ -0,0 +1,137 @@
+/*! \file scheduler.h
+ * Background chunk generation. Requests go into a queue ordered by
+ * priority (lower first, e.g. distance to the viewer) and a set of worker
+ * threads generates them into a ChunkCache while the caller keeps drawing.
+ * Asking again for a queued chunk joins the request already there, and a
+ * moving viewer can reorder or drop the whole queue in one call.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "chunk.h"
+
+class ChunkScheduler {
+public:
+    typedef ChunkCache::Chunk Chunk;
+    typedef std::shared_future<Chunk> Future;
+
+    /**************************************************************************
+     * ChunkDone: called once per request with the chunk, or an empty
+     * pointer if the request was cancelled. Runs on a worker thread, or on
+     * the caller's for a chunk that was cached or a cancel() call.
+     **************************************************************************/
+    typedef std::function<void(int cx, int cz, Chunk chunk)> ChunkDone;
+
+    /**************************************************************************
+     * ChunkPriority: the priority of chunk (cx, cz), lower runs first.
+     **************************************************************************/
+    typedef std::function<float(int cx, int cz)> ChunkPriority;
+
+    /**************************************************************************
+     * threads workers generate into cache, 0 for one per hardware thread.
+     **************************************************************************/
+    ChunkScheduler(ChunkCache &cache, int threads = 0);
+    ~ChunkScheduler();
+    ChunkScheduler(const ChunkScheduler &) = delete;
+    ChunkScheduler &operator=(const ChunkScheduler &) = delete;
+
+    /**************************************************************************
+     * request: chunk (cx, cz). A cached chunk comes back ready. A chunk
+     * already queued keeps its one job and takes the lower of the two
+     * priorities; the future is shared with the earlier requests.
+     **************************************************************************/
+    Future request(int cx, int cz, float priority, const ChunkDone &done = ChunkDone());
+
+    /**************************************************************************
+     * requestRegion: every chunk cx0..cx1, cz0..cz1 (inclusive), each at
+     * priority(cx, cz). Futures come back row by row.
+     **************************************************************************/
+    std::vector<Future> requestRegion(int cx0, int cz0, int cx1, int cz1,
+                                      const ChunkPriority &priority,
+                                      const ChunkDone &done = ChunkDone());
+
+    /**************************************************************************
+     * reprioritize: moves one queued chunk to priority. False if it is not
+     * queued (done, running or never asked for).
+     **************************************************************************/
+    bool reprioritize(int cx, int cz, float priority);
+
+    /**************************************************************************
+     * retarget: gives every queued chunk priority(cx, cz) and cancels those
+     * that come out above cutoff, e.g. the ones the viewer left behind.
+     * Returns the number cancelled. priority runs with the scheduler locked
+     * and must not call back into it.
+     **************************************************************************/
+    int retarget(const ChunkPriority &priority, float cutoff);
+
+    /**************************************************************************
+     * cancel: drops a queued chunk; its futures get an empty pointer. A
+     * chunk already being generated is finished instead and false returned.
+     **************************************************************************/
+    bool cancel(int cx, int cz);
+
+    /**************************************************************************
+     * drain: waits until the queue is empty and every worker has answered
+     * its last chunk, callbacks included.
+     **************************************************************************/
+    void drain();
+
+    int threads() const { return (int)workers.size(); }
+    size_t pending() const;
+    unsigned long generated() const;
+    unsigned long coalesced() const;
+    unsigned long cancelled() const;
+
+private:
+    struct Task {
+        float priority;
+        unsigned version;               // new stamp on every (re)queue
+        bool running;
+        std::promise<Chunk> promise;
+        Future future;
+        std::vector<ChunkDone> done;
+    };
+    struct Finished {
+        int cx, cz;
+        std::promise<Chunk> promise;
+        std::vector<ChunkDone> done;
+    };
+    struct Queued {
+        float priority;
+        unsigned version;
+        uint64_t key;
+        bool operator<(const Queued &other) const { return priority > other.priority; }
+    };
+    typedef std::unordered_map<uint64_t, Task> Tasks;
+
+    static uint64_t keyOf(int cx, int cz);
+    static void chunkOf(uint64_t key, int &cx, int &cz);
+    void enqueue(uint64_t key, Task &task, float priority);
+    static Finished take(uint64_t key, Task &task);
+    static void deliver(Finished &finished, Chunk chunk);
+    void work();
+
+    ChunkCache &cache;
+    std::vector<std::thread> workers;
+    mutable std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    Tasks tasks;                        // queued and running, by chunk
+    std::priority_queue<Queued> queue;  // stale entries are skipped by version
+    int busy;                           // workers between taking a task and answering it
+    unsigned stamp;                     // last version handed out
+    unsigned long made, joined, dropped;
+    bool quit;
+};
+
+#endif
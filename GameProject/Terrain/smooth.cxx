@@ -0,0 +1,145 @@
+/*! \file smooth.cxx
+ * Neighbourhood smoothing used after generation.
+ */
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "trace.h"
+#include "smooth.h"
+#include "smoothrow.h"
+
+const int ROW_BLOCK = 16;       // rows one task of the box row pass slides together
+const int COLUMN_BLOCK = 64;    // columns one task of a column pass runs down
+
+/******************************************************************************
+ * padRow: row with radius cells on either side read through border.
+ ******************************************************************************/
+static void padRow(const float *row, int width, int radius, BorderPolicy border, float *padded){
+    for (int k = -radius; k < 0; k++)
+        padded[k + radius] = row[borderIndex(k, width, border)];
+    std::copy(row, row + width, padded + radius);
+    for (int k = width; k < width + radius; k++)
+        padded[k + radius] = row[borderIndex(k, width, border)];
+}
+
+/******************************************************************************
+ * capRadius: the widest radius borderIndex() can serve on map.
+ ******************************************************************************/
+static int capRadius(HeightmapView map, int radius){
+    return std::min(radius, std::min(map.width, map.height) - 2);
+}
+
+void boxBlur(HeightmapView map, int radius, BorderPolicy border, ThreadPool *pool){
+    TRACE_ZONE("boxBlur");
+    radius = capRadius(map, radius);
+    if (radius < 1)
+        return;
+    const int width = map.width, height = map.height, taps = 2 * radius + 1;
+    const double scale = 1.0 / taps;
+    const SlideRow slide = cpuHasAVX2() ? slideRowAVX2 : slideRowScalar;
+    Heightmap scratch(width, height);
+
+    //along the rows: a running sum per row, kept in double so adding and
+    //dropping cells over a long row does not drift. A block of rows is
+    //interleaved cell by cell so each step slides all of their sums at
+    //once, like the column pass does across columns
+    const int rowBlocks = (height + ROW_BLOCK - 1) / ROW_BLOCK;
+    parallelFor(pool, 0, rowBlocks, [&](int first, int last){
+        const int span = width + 2 * radius;
+        std::vector<float> padded(span), lanes(span * ROW_BLOCK), out(width * ROW_BLOCK);
+        std::vector<double> sum(ROW_BLOCK);
+        for (int b = first; b < last; b++){
+            const int r0 = b * ROW_BLOCK, n = std::min(ROW_BLOCK, height - r0);
+            for (int i = 0; i < n; i++){
+                padRow(map[r0 + i], width, radius, border, &padded[0]);
+                for (int c = 0; c < span; c++)
+                    lanes[c * ROW_BLOCK + i] = padded[c];
+            }
+            std::fill(sum.begin(), sum.end(), 0.0);
+            for (int k = 0; k < taps; k++)
+                for (int i = 0; i < n; i++)
+                    sum[i] += lanes[k * ROW_BLOCK + i];
+            for (int i = 0; i < n; i++)
+                out[i] = sum[i] * scale;
+            for (int c = 1; c < width; c++)
+                slide(&sum[0], &lanes[(c + taps - 1) * ROW_BLOCK], &lanes[(c - 1) * ROW_BLOCK],
+                      scale, &out[c * ROW_BLOCK], n);
+            for (int i = 0; i < n; i++){
+                float *row = scratch[r0 + i];
+                for (int c = 0; c < width; c++)
+                    row[c] = out[c * ROW_BLOCK + i];
+            }
+        }
+    });
+
+    //down the columns: a running sum per column, a block of columns at a
+    //time, each step adding the row entering the window and dropping the
+    //one leaving it
+    const int blocks = (width + COLUMN_BLOCK - 1) / COLUMN_BLOCK;
+    parallelFor(pool, 0, blocks, [&](int first, int last){
+        std::vector<double> sum(COLUMN_BLOCK);
+        for (int b = first; b < last; b++){
+            const int c0 = b * COLUMN_BLOCK, n = std::min(COLUMN_BLOCK, width - c0);
+            std::fill(sum.begin(), sum.end(), 0.0);
+            for (int k = -radius; k <= radius; k++){
+                const float *in = scratch[borderIndex(k, height, border)] + c0;
+                for (int c = 0; c < n; c++)
+                    sum[c] += in[c];
+            }
+            for (int c = 0; c < n; c++)
+                map[0][c0 + c] = sum[c] * scale;
+            for (int r = 1; r < height; r++)
+                slide(&sum[0], scratch[borderIndex(r + radius, height, border)] + c0,
+                      scratch[borderIndex(r - radius - 1, height, border)] + c0,
+                      scale, map[r] + c0, n);
+        }
+    });
+}
+
+void gaussianBlur(HeightmapView map, float sigma, BorderPolicy border, ThreadPool *pool){
+    TRACE_ZONE("gaussianBlur");
+    if (!(sigma > 0.0f))
+        return;
+    const int radius = capRadius(map, (int)ceilf(3.0f * sigma));
+    if (radius < 1)
+        return;
+    const int width = map.width, height = map.height, taps = 2 * radius + 1;
+    std::vector<float> weight(taps);
+    double total = 0.0;
+    for (int k = 0; k < taps; k++){
+        double x = k - radius;
+        weight[k] = exp(-x * x / (2.0 * sigma * sigma));
+        total += weight[k];
+    }
+    for (int k = 0; k < taps; k++)
+        weight[k] /= total;
+    const WeighRow weigh = cpuHasAVX2() ? weighRowAVX2 : weighRowScalar;
+    Heightmap scratch(width, height);
+
+    //along the rows: tap by tap over the whole padded row
+    parallelFor(pool, 0, height, [&](int first, int last){
+        std::vector<float> padded(width + 2 * radius);
+        for (int r = first; r < last; r++){
+            padRow(map[r], width, radius, border, &padded[0]);
+            float *out = scratch[r];
+            std::fill(out, out + width, 0.0f);
+            for (int k = 0; k < taps; k++)
+                weigh(out, &padded[k], weight[k], width);
+        }
+    });
+
+    //down the columns: each output row is a weighted sum of whole rows
+    parallelFor(pool, 0, height, [&](int first, int last){
+        for (int r = first; r < last; r++){
+            float *out = map[r];
+            std::fill(out, out + width, 0.0f);
+            for (int k = 0; k < taps; k++)
+                weigh(out, scratch[borderIndex(r - radius + k, height, border)], weight[k], width);
+        }
+    });
+}
+
+void smooth(HeightmapView map, BorderPolicy border, ThreadPool *pool) {
+    boxBlur(map, 1, border, pool);
+}
@@ -0,0 +1,40 @@
+/*! \file smooth.h
+ * Neighbourhood smoothing used after generation. Both filters are
+ * separable: a pass along the rows into a scratch map, then a pass down
+ * the columns back into the map, so no output depends on the order cells
+ * are visited in. The row pass splits rows across the pool and the column
+ * pass blocks of columns. The inner loops are the kernels in smoothrow.h,
+ * which run 4 or 8 cells per AVX2 step; the box row pass interleaves a
+ * block of rows so its running sums step side by side. Heights stay
+ * floats throughout.
+ */
+
+#ifndef SMOOTH_H
+#define SMOOTH_H
+
+#include "heightmap.h"
+#include "threadpool.h"
+
+/******************************************************************************
+ * boxBlur: every cell becomes the mean of the (2 radius + 1)^2 square
+ * around it, cells past the edge as border gives them. Running sums make
+ * the cost per cell the same for any radius. The radius is capped at the
+ * map's shorter side less 2.
+ ******************************************************************************/
+void boxBlur(HeightmapView map, int radius, BorderPolicy border = BORDER_WRAP, ThreadPool *pool = NULL);
+
+/******************************************************************************
+ * gaussianBlur: the map convolved with a Gaussian of standard deviation
+ * sigma cells, cut off at 3 sigma, with the same border and cap as
+ * boxBlur. sigma <= 0 leaves the map alone.
+ ******************************************************************************/
+void gaussianBlur(HeightmapView map, float sigma, BorderPolicy border = BORDER_WRAP,
+                  ThreadPool *pool = NULL);
+
+/******************************************************************************
+ * smooth: band smoothing. takes into account its neightbor's heights, those
+ * past the edge as border gives them: the 3 x 3 box blur
+ ******************************************************************************/
+void smooth(HeightmapView map, BorderPolicy border = BORDER_WRAP, ThreadPool *pool = NULL);
+
+#endif
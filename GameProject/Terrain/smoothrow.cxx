@@ -0,0 +1,72 @@
+/*! \file smoothrow.cxx
+ * Row kernels for the smoothing filters: AVX2 slides 4 running sums or
+ * weighs 8 cells per step, with the same operations in the same order as
+ * the scalar kernels, so the map does not depend on which one ran.
+ *
+ * The AVX2 kernels are compiled with a target attribute and only called
+ * after cpuHasAVX2 said yes, so the rest of the library still builds for
+ * the baseline CPU.
+ */
+
+#include "smoothrow.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+void slideRowScalar(double *sum, const float *enter, const float *leave,
+                    double scale, float *out, int count){
+    for (int n = 0; n < count; n++){
+        sum[n] += (double)enter[n] - leave[n];
+        out[n] = sum[n] * scale;
+    }
+}
+
+void weighRowScalar(float *out, const float *in, float weight, int count){
+    for (int n = 0; n < count; n++)
+        out[n] += weight * in[n];
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/******************************************************************************
+ * slideRowAVX2: the floats are widened 4 at a time so the sums stay in
+ * double like the scalar ones.
+ ******************************************************************************/
+__attribute__((target("avx2")))
+void slideRowAVX2(double *sum, const float *enter, const float *leave,
+                  double scale, float *out, int count){
+    const __m256d s = _mm256_set1_pd(scale);
+    int n = 0;
+    for (; n + 4 <= count; n += 4){
+        __m256d step = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(enter + n)),
+                                     _mm256_cvtps_pd(_mm_loadu_ps(leave + n)));
+        __m256d v = _mm256_add_pd(_mm256_loadu_pd(sum + n), step);
+        _mm256_storeu_pd(sum + n, v);
+        _mm_storeu_ps(out + n, _mm256_cvtpd_ps(_mm256_mul_pd(v, s)));
+    }
+    slideRowScalar(sum + n, enter + n, leave + n, scale, out + n, count - n);
+}
+
+__attribute__((target("avx2")))
+void weighRowAVX2(float *out, const float *in, float weight, int count){
+    const __m256 w = _mm256_set1_ps(weight);
+    int n = 0;
+    for (; n + 8 <= count; n += 8)
+        _mm256_storeu_ps(out + n, _mm256_add_ps(_mm256_loadu_ps(out + n),
+                                                _mm256_mul_ps(w, _mm256_loadu_ps(in + n))));
+    weighRowScalar(out + n, in + n, weight, count - n);
+}
+
+#else
+
+void slideRowAVX2(double *sum, const float *enter, const float *leave,
+                  double scale, float *out, int count){
+    slideRowScalar(sum, enter, leave, scale, out, count);
+}
+
+void weighRowAVX2(float *out, const float *in, float weight, int count){
+    weighRowScalar(out, in, weight, count);
+}
+
+#endif
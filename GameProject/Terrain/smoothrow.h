@@ -0,0 +1,32 @@
+/*! \file smoothrow.h
+ * Row kernels behind boxBlur() and gaussianBlur(). Both passes of both
+ * filters come down to one of two element-wise sweeps over a run of
+ * cells: box slides a running sum one step, Gaussian adds one weighted
+ * tap. The AVX2 versions live in smoothrow.cxx and match the scalar ones
+ * bit for bit.
+ */
+
+#ifndef SMOOTHROW_H
+#define SMOOTHROW_H
+
+#include "cpu.h"
+
+typedef void (*SlideRow)(double *sum, const float *enter, const float *leave,
+                         double scale, float *out, int count);
+typedef void (*WeighRow)(float *out, const float *in, float weight, int count);
+
+/******************************************************************************
+ * slideRow: sum += enter - leave in double, out = sum * scale.
+ ******************************************************************************/
+void slideRowScalar(double *sum, const float *enter, const float *leave,
+                    double scale, float *out, int count);
+void slideRowAVX2(double *sum, const float *enter, const float *leave,
+                  double scale, float *out, int count);
+
+/******************************************************************************
+ * weighRow: out += weight * in.
+ ******************************************************************************/
+void weighRowScalar(float *out, const float *in, float weight, int count);
+void weighRowAVX2(float *out, const float *in, float weight, int count);
+
+#endif
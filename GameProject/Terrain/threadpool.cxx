@@ -0,0 +1,81 @@
+/*! \file threadpool.cxx
+ * Fixed set of worker threads.
+ */
+
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(int threads)
+    : job(NULL), jobLast(0), grain(1), next(0), busy(0), generation(0), quit(false) {
+    if (threads <= 0)
+        threads = std::thread::hardware_concurrency();
+    for (int i = 1; i < threads; i++)
+        workers.push_back(std::thread(&ThreadPool::work, this));
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        quit = true;
+    }
+    wake.notify_all();
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+}
+
+void ThreadPool::parallelFor(int first, int last, const std::function<void(int, int)> &body){
+    if (first >= last)
+        return;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        job = &body;
+        jobLast = last;
+        //a few chunks per thread so uneven rows still balance
+        grain = (last - first) / (size() * 4);
+        if (grain < 1)
+            grain = 1;
+        next.store(first);
+        busy = workers.size();
+        generation++;
+    }
+    wake.notify_all();
+    runChunks();
+
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [this]{ return busy == 0; });
+    job = NULL;
+}
+
+/******************************************************************************
+ * runChunks: grabs ranges of the current job until none are left.
+ ******************************************************************************/
+void ThreadPool::runChunks(){
+    for (;;){
+        int begin = next.fetch_add(grain);
+        if (begin >= jobLast)
+            return;
+        int end = begin + grain < jobLast ? begin + grain : jobLast;
+        (*job)(begin, end);
+    }
+}
+
+/******************************************************************************
+ * work: worker thread loop, sleeps until a new job or shutdown.
+ ******************************************************************************/
+void ThreadPool::work(){
+    unsigned seen = 0;
+    for (;;){
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [&]{ return quit || generation != seen; });
+            if (quit)
+                return;
+            seen = generation;
+        }
+        runChunks();
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (--busy == 0)
+                done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,69 @@
+/*! \file threadpool.h
+ * Fixed set of worker threads for the data parallel passes of the
+ * generators. parallelFor hands out contiguous index ranges; the calling
+ * thread works too and the call returns once every index is done.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    /**************************************************************************
+     * threads counts the calling thread, so ThreadPool(4) starts 3 workers.
+     * 0 means one per hardware thread.
+     **************************************************************************/
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int size() const { return (int)workers.size() + 1; }
+
+    /**************************************************************************
+     * parallelFor: calls body(begin, end) on disjoint ranges covering
+     * [first, last). Ranges may run in any order on any thread, so body must
+     * not depend on either. Not reentrant: body must not call parallelFor.
+     **************************************************************************/
+    void parallelFor(int first, int last, const std::function<void(int, int)> &body);
+
+private:
+    void work();
+    void runChunks();
+
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(int, int)> *job;
+    int jobLast;
+    int grain;
+    std::atomic<int> next;
+    int busy;               // workers still inside the current job
+    unsigned generation;    // bumped for every job so workers see new work
+    bool quit;
+};
+
+/******************************************************************************
+ * parallelFor: runs body on pool, or inline when pool is NULL so callers
+ * need only one code path.
+ ******************************************************************************/
+inline void parallelFor(ThreadPool *pool, int first, int last,
+                        const std::function<void(int, int)> &body){
+    if (first >= last)
+        return;
+    if (pool == NULL || pool->size() == 1 || last - first == 1)
+        body(first, last);
+    else
+        pool->parallelFor(first, last, body);
+}
+
+#endif
@@ -0,0 +1,396 @@
+/*! \file tin.cxx
+ * Triangulated irregular networks by greedy insertion.
+ *
+ * Triangle t owns half edges 3t, 3t+1 and 3t+2; half edge e runs from
+ * corner[e] to the next corner of its triangle, and twin[e] is the same
+ * edge in the neighbouring triangle, -1 on the map border. Every triangle
+ * is wound so orient() of its corners is positive.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include "tin.h"
+
+namespace {
+
+struct Point {
+    int x, z;
+};
+
+/******************************************************************************
+ * orient: twice the signed area of abc, positive for the winding every
+ * triangle here has.
+ ******************************************************************************/
+inline long long orient(Point a, Point b, Point c){
+    return (long long)(b.x - c.x) * (a.z - c.z) - (long long)(b.z - c.z) * (a.x - c.x);
+}
+
+inline bool collinear(Point a, Point b, Point c){
+    return orient(a, b, c) == 0;
+}
+
+/******************************************************************************
+ * inCircle: p lies inside the circle through a, b and c.
+ ******************************************************************************/
+inline bool inCircle(Point a, Point b, Point c, Point p){
+    double dx = a.x - p.x, dz = a.z - p.z;
+    double ex = b.x - p.x, ez = b.z - p.z;
+    double fx = c.x - p.x, fz = c.z - p.z;
+    double ap = dx * dx + dz * dz, bp = ex * ex + ez * ez, cp = fx * fx + fz * fz;
+    return dx * (ez * cp - bp * fz) - dz * (ex * cp - bp * fx) + ap * (ex * fz - ez * fx) < 0.0;
+}
+
+class Triangulator {
+public:
+    explicit Triangulator(HeightmapView map) : map(map) {}
+
+    void run(float maxError, size_t maxTriangles);
+    void result(Tin &out) const;
+
+private:
+    int addPoint(Point p);
+    int addTriangle(int a, int b, int c, int ab, int bc, int ca, int e);
+    void step();
+    void splitEdge(int p, int e);
+    void legalize(int e);
+    void flush();
+    void scan(int t);
+
+    float height(Point p) const { return map[p.z][p.x]; }
+
+    //the heap of triangles by error, largest first
+    bool before(int i, int j) const { return error[heap[i]] > error[heap[j]]; }
+    void swapHeap(int i, int j);
+    void up(int i);
+    bool down(int i);
+    void push(int t);
+    int pop();
+    void remove(int t);
+
+    HeightmapView map;
+    std::vector<Point> points;
+    std::vector<int> corner;        // per half edge
+    std::vector<int> twin;          // per half edge
+    std::vector<Point> candidate;   // per triangle, its worst sample
+    std::vector<float> error;       // per triangle, that sample's error
+    std::vector<int> slot;          // per triangle, its place in heap or -1
+    std::vector<int> heap;
+    std::vector<int> pending;       // triangles to scan before the next step
+};
+
+void Triangulator::run(float maxError, size_t maxTriangles){
+    const int right = map.width - 1, bottom = map.height - 1;
+    Point topLeft = { 0, 0 }, topRight = { right, 0 };
+    Point bottomLeft = { 0, bottom }, bottomRight = { right, bottom };
+    int p0 = addPoint(topLeft), p1 = addPoint(topRight);
+    int p2 = addPoint(bottomLeft), p3 = addPoint(bottomRight);
+    //split along the same diagonal as a TerrainMesh cell
+    int t0 = addTriangle(p0, p2, p1, -1, -1, -1, -1);
+    addTriangle(p1, p2, p3, t0 + 1, -1, -1, -1);
+    flush();
+    while (!heap.empty() && error[heap[0]] > maxError
+           && (maxTriangles == 0 || corner.size() / 3 < maxTriangles))
+        step();
+}
+
+void Triangulator::result(Tin &out) const {
+    out.points.resize(points.size());
+    for (size_t i = 0; i < points.size(); i++){
+        TinPoint p = { points[i].x, points[i].z, height(points[i]) };
+        out.points[i] = p;
+    }
+    out.triangles.assign(corner.begin(), corner.end());
+    out.error = heap.empty() ? 0.0f : error[heap[0]];
+}
+
+int Triangulator::addPoint(Point p){
+    points.push_back(p);
+    return points.size() - 1;
+}
+
+/******************************************************************************
+ * addTriangle: sets triangle abc with twins ab, bc and ca in the slot of
+ * half edge e, or in a new slot if e is -1, and queues it for a scan.
+ * Returns its first half edge.
+ ******************************************************************************/
+int Triangulator::addTriangle(int a, int b, int c, int ab, int bc, int ca, int e){
+    if (e < 0){
+        e = corner.size();
+        corner.resize(e + 3);
+        twin.resize(e + 3);
+        Point none = { 0, 0 };
+        candidate.push_back(none);
+        error.push_back(0.0f);
+        slot.push_back(-1);
+    }
+    corner[e] = a;
+    corner[e + 1] = b;
+    corner[e + 2] = c;
+    twin[e] = ab;
+    twin[e + 1] = bc;
+    twin[e + 2] = ca;
+    if (ab >= 0)
+        twin[ab] = e;
+    if (bc >= 0)
+        twin[bc] = e + 1;
+    if (ca >= 0)
+        twin[ca] = e + 2;
+    pending.push_back(e / 3);
+    return e;
+}
+
+/******************************************************************************
+ * step: inserts the worst triangle's candidate, splitting the triangle in
+ * three, or the edge it sits on in two.
+ ******************************************************************************/
+void Triangulator::step(){
+    const int t = pop();
+    const int e0 = 3 * t, e1 = e0 + 1, e2 = e0 + 2;
+    const int p0 = corner[e0], p1 = corner[e1], p2 = corner[e2];
+    const Point p = candidate[t];
+    const int pn = addPoint(p);
+    if (collinear(points[p0], points[p1], p))
+        splitEdge(pn, e0);
+    else if (collinear(points[p1], points[p2], p))
+        splitEdge(pn, e1);
+    else if (collinear(points[p2], points[p0], p))
+        splitEdge(pn, e2);
+    else {
+        const int h0 = twin[e0], h1 = twin[e1], h2 = twin[e2];
+        int t0 = addTriangle(p0, p1, pn, h0, -1, -1, e0);
+        int t1 = addTriangle(p1, p2, pn, h1, -1, t0 + 1, -1);
+        int t2 = addTriangle(p2, p0, pn, h2, t0 + 2, t1 + 1, -1);
+        legalize(t0);
+        legalize(t1);
+        legalize(t2);
+    }
+    flush();
+}
+
+/******************************************************************************
+ * splitEdge: inserts point p on half edge e, splitting the triangles on
+ * either side of it.
+ ******************************************************************************/
+void Triangulator::splitEdge(int p, int e){
+    const int e0 = e - e % 3, left = e0 + (e + 1) % 3, right = e0 + (e + 2) % 3;
+    const int p0 = corner[right], pr = corner[e], pl = corner[left];
+    const int hl = twin[left], hr = twin[right];
+    const int f = twin[e];
+    if (f < 0){
+        int t0 = addTriangle(p, p0, pr, -1, hr, -1, e0);
+        int t1 = addTriangle(p0, p, pl, t0, -1, hl, -1);
+        legalize(t0 + 1);
+        legalize(t1 + 2);
+        return;
+    }
+    const int f0 = f - f % 3, fl = f0 + (f + 2) % 3, fr = f0 + (f + 1) % 3;
+    const int p1 = corner[fl];
+    const int gl = twin[fl], gr = twin[fr];
+    remove(f / 3);
+    int t0 = addTriangle(p0, pr, p, hr, -1, -1, e0);
+    int t1 = addTriangle(pr, p1, p, gr, -1, t0 + 1, f0);
+    int t2 = addTriangle(p1, pl, p, gl, -1, t1 + 1, -1);
+    int t3 = addTriangle(pl, p0, p, hl, t0 + 2, t2 + 1, -1);
+    legalize(t0);
+    legalize(t1);
+    legalize(t2);
+    legalize(t3);
+}
+
+/******************************************************************************
+ * legalize: flips half edge e if the point across it lies inside its
+ * triangle's circumcircle, then checks the two edges the flip exposed.
+ *
+ *           pl                    pl
+ *          /||\                  /  \
+ *       al/ || \bl            al/    \a
+ *        /  ||  \              /      \
+ *       /  e||f  \    flip    /___ar___\
+ *     p0\   ||   /p1   =>   p0\---bl---/p1
+ *        \  ||  /              \      /
+ *       ar\ || /br             b\    /br
+ *          \||/                  \  /
+ *           pr                    pr
+ ******************************************************************************/
+void Triangulator::legalize(int e){
+    const int f = twin[e];
+    if (f < 0)
+        return;
+    const int e0 = e - e % 3, f0 = f - f % 3;
+    const int al = e0 + (e + 1) % 3, ar = e0 + (e + 2) % 3;
+    const int bl = f0 + (f + 2) % 3, br = f0 + (f + 1) % 3;
+    const int p0 = corner[ar], pr = corner[e], pl = corner[al], p1 = corner[bl];
+    if (!inCircle(points[p0], points[pr], points[pl], points[p1]))
+        return;
+    const int hal = twin[al], har = twin[ar], hbl = twin[bl], hbr = twin[br];
+    remove(e / 3);
+    remove(f / 3);
+    int t0 = addTriangle(p0, p1, pl, -1, hbl, hal, e0);
+    int t1 = addTriangle(p1, p0, pr, t0, har, hbr, f0);
+    legalize(t0 + 1);
+    legalize(t1 + 2);
+}
+
+void Triangulator::flush(){
+    for (size_t i = 0; i < pending.size(); i++){
+        scan(pending[i]);
+        push(pending[i]);
+    }
+    pending.clear();
+}
+
+/******************************************************************************
+ * scan: walks the samples of triangle t row by row with incremental edge
+ * functions, skipping ahead to where each row enters the triangle, and
+ * keeps the one furthest from the triangle's plane.
+ ******************************************************************************/
+void Triangulator::scan(int t){
+    const Point a = points[corner[3 * t]], b = points[corner[3 * t + 1]], c = points[corner[3 * t + 2]];
+    Point lo = { std::min(std::min(a.x, b.x), c.x), std::min(std::min(a.z, b.z), c.z) };
+    Point hi = { std::max(std::max(a.x, b.x), c.x), std::max(std::max(a.z, b.z), c.z) };
+    //edge functions at lo and their steps along x and z
+    long long w00 = orient(b, c, lo), w01 = orient(c, a, lo), w02 = orient(a, b, lo);
+    const long long a12 = c.z - b.z, b12 = b.x - c.x;
+    const long long a20 = a.z - c.z, b20 = c.x - a.x;
+    const long long a01 = b.z - a.z, b01 = a.x - b.x;
+    const double area = (double)orient(a, b, c);
+    const double za = height(a) / area, zb = height(b) / area, zc = height(c) / area;
+
+    float worst = 0.0f;
+    Point at = a;
+    for (int z = lo.z; z <= hi.z; z++){
+        long long dx = 0;
+        if (w00 < 0 && a12 > 0)
+            dx = std::max(dx, (-w00 + a12 - 1) / a12);
+        if (w01 < 0 && a20 > 0)
+            dx = std::max(dx, (-w01 + a20 - 1) / a20);
+        if (w02 < 0 && a01 > 0)
+            dx = std::max(dx, (-w02 + a01 - 1) / a01);
+        long long w0 = w00 + a12 * dx, w1 = w01 + a20 * dx, w2 = w02 + a01 * dx;
+        const float *row = map[z];
+        bool inside = false;
+        for (int x = lo.x + dx; x <= hi.x; x++){
+            if (w0 >= 0 && w1 >= 0 && w2 >= 0){
+                inside = true;
+                float off = fabsf((float)(za * w0 + zb * w1 + zc * w2) - row[x]);
+                if (off > worst){
+                    worst = off;
+                    at.x = x;
+                    at.z = z;
+                }
+            }
+            else if (inside)
+                break;
+            w0 += a12;
+            w1 += a20;
+            w2 += a01;
+        }
+        w00 += b12;
+        w01 += b20;
+        w02 += b01;
+    }
+    //a corner is already in, so the triangle is exact
+    if ((at.x == a.x && at.z == a.z) || (at.x == b.x && at.z == b.z) || (at.x == c.x && at.z == c.z))
+        worst = 0.0f;
+    candidate[t] = at;
+    error[t] = worst;
+}
+
+void Triangulator::swapHeap(int i, int j){
+    std::swap(heap[i], heap[j]);
+    slot[heap[i]] = i;
+    slot[heap[j]] = j;
+}
+
+void Triangulator::up(int i){
+    while (i > 0){
+        int parent = (i - 1) / 2;
+        if (!before(i, parent))
+            break;
+        swapHeap(i, parent);
+        i = parent;
+    }
+}
+
+bool Triangulator::down(int i){
+    const int start = i, n = heap.size();
+    for (;;){
+        int child = 2 * i + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && before(child + 1, child))
+            child++;
+        if (!before(child, i))
+            break;
+        swapHeap(i, child);
+        i = child;
+    }
+    return i > start;
+}
+
+void Triangulator::push(int t){
+    slot[t] = heap.size();
+    heap.push_back(t);
+    up(heap.size() - 1);
+}
+
+int Triangulator::pop(){
+    const int t = heap[0];
+    const int last = heap.size() - 1;
+    if (last > 0)
+        swapHeap(0, last);
+    heap.pop_back();
+    slot[t] = -1;
+    if (!heap.empty())
+        down(0);
+    return t;
+}
+
+/******************************************************************************
+ * remove: takes t out of the heap, or out of pending if it was not scanned
+ * yet.
+ ******************************************************************************/
+void Triangulator::remove(int t){
+    const int i = slot[t];
+    if (i < 0){
+        std::vector<int>::iterator it = std::find(pending.begin(), pending.end(), t);
+        if (it != pending.end()){
+            *it = pending.back();
+            pending.pop_back();
+        }
+        return;
+    }
+    const int last = heap.size() - 1;
+    if (i != last){
+        swapHeap(i, last);
+        heap.pop_back();
+        if (!down(i))
+            up(i);
+    }
+    else
+        heap.pop_back();
+    slot[t] = -1;
+}
+
+}
+
+void simplify(HeightmapView map, float maxError, Tin &out, size_t maxTriangles){
+    Triangulator triangulator(map);
+    triangulator.run(maxError, maxTriangles);
+    triangulator.result(out);
+}
+
+bool writeTinObj(const char *path, const Tin &tin, float x0, float z0, float spacing){
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+        return false;
+    for (size_t i = 0; i < tin.points.size(); i++){
+        const TinPoint &p = tin.points[i];
+        fprintf(fp, "v %g %g %g\n", x0 + p.x * spacing, p.height, z0 + p.z * spacing);
+    }
+    //OBJ counts from 1
+    for (size_t i = 0; i + 2 < tin.triangles.size(); i += 3)
+        fprintf(fp, "f %u %u %u\n", tin.triangles[i] + 1, tin.triangles[i+1] + 1, tin.triangles[i+2] + 1);
+    return fclose(fp) == 0;
+}
@@ -0,0 +1,45 @@
+/*! \file tin.h
+ * Triangulated irregular networks by greedy insertion (Garland and
+ * Heckbert, "Fast polygonal approximation of terrains and height fields").
+ * The network starts as the map's two corner triangles. Every triangle
+ * knows the sample inside it that its plane misses by most, and a heap
+ * keeps the triangles in order of that error; the worst triangle's sample
+ * is inserted and the triangulation kept Delaunay by edge flips, then just
+ * the triangles that changed are scanned again. Flat ground stays a few
+ * large triangles however big the map is.
+ */
+
+#ifndef TIN_H
+#define TIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "heightmap.h"
+
+struct TinPoint {
+    int x, z;               // column and row in the map
+    float height;
+};
+
+struct Tin {
+    std::vector<TinPoint> points;
+    std::vector<uint32_t> triangles;    // three points each, wound like TerrainMesh
+    float error;                        // largest vertical error left
+};
+
+/******************************************************************************
+ * simplify: the fewest points greedy insertion needs to bring every sample
+ * of map within maxError of the network, or the network when it reaches
+ * maxTriangles if that is not 0.
+ ******************************************************************************/
+void simplify(HeightmapView map, float maxError, Tin &out, size_t maxTriangles = 0);
+
+/******************************************************************************
+ * writeTinObj: tin as a Wavefront OBJ file, sample (r, c) at
+ * x = x0 + c * spacing, z = z0 + r * spacing. Returns false if the file
+ * could not be written.
+ ******************************************************************************/
+bool writeTinObj(const char *path, const Tin &tin, float x0, float z0, float spacing);
+
+#endif
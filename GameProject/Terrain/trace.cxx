@@ -0,0 +1,149 @@
+/*! \file trace.cxx
+ * Phase level tracing. Empty unless TERRAIN_TRACE is defined.
+ */
+
+#include "trace.h"
+
+#ifdef TERRAIN_TRACE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> traceOn(false);
+
+struct TraceEvent {
+    const char *name;
+    uint64_t begin;
+    uint64_t end;           // 0 for a counter
+    double value;
+};
+
+/******************************************************************************
+ * TraceBuffer: one thread's events. Buffers live until exit so the events
+ * of finished threads still get written.
+ ******************************************************************************/
+struct TraceBuffer {
+    int tid;
+    uint64_t since;         // the epoch events was last cleared for
+    std::vector<TraceEvent> events;
+};
+
+static const size_t TRACE_RESERVE = 1 << 16;   // events per thread before the first regrow
+
+static std::mutex registry;
+static std::vector<TraceBuffer *> buffers;
+static std::atomic<uint64_t> epoch(0);
+static const char *atExitPath;
+
+/******************************************************************************
+ * local: the calling thread's buffer, registered on first use.
+ ******************************************************************************/
+static TraceBuffer &local(){
+    static thread_local TraceBuffer *mine = NULL;
+    if (mine == NULL){
+        mine = new TraceBuffer;
+        mine->since = 0;
+        mine->events.reserve(TRACE_RESERVE);
+        std::lock_guard<std::mutex> guard(registry);
+        mine->tid = buffers.size() + 1;
+        buffers.push_back(mine);
+    }
+    return *mine;
+}
+
+uint64_t traceNow(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/******************************************************************************
+ * record: appends e to the calling thread's buffer, first dropping what the
+ * buffer holds from before the last traceStart(). Only the owning thread
+ * ever clears a buffer, so traceStart() can run while others record.
+ ******************************************************************************/
+static void record(const TraceEvent &e){
+    TraceBuffer &buf = local();
+    const uint64_t now = epoch.load();
+    if (buf.since != now){
+        buf.events.clear();
+        buf.since = now;
+    }
+    buf.events.push_back(e);
+}
+
+void traceZone(const char *name, uint64_t begin, uint64_t end){
+    TraceEvent e = { name, begin, end, 0.0 };
+    record(e);
+}
+
+void traceCounter(const char *name, double value){
+    TraceEvent e = { name, traceNow(), 0, value };
+    record(e);
+}
+
+void traceStart(){
+    epoch.store(traceNow());
+    traceOn.store(true);
+}
+
+void traceStop(){
+    traceOn.store(false);
+}
+
+bool writeTrace(const char *path){
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL)
+        return false;
+    std::lock_guard<std::mutex> guard(registry);
+    const uint64_t since = epoch.load();
+    fprintf(fp, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    const char *sep = "";
+    for (size_t b = 0; b < buffers.size(); b++){
+        const TraceBuffer &buf = *buffers[b];
+        fprintf(fp, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                    "\"args\": {\"name\": \"thread %d\"}}", sep, buf.tid, buf.tid);
+        sep = ",\n";
+        for (size_t i = 0; i < buf.events.size(); i++){
+            const TraceEvent &e = buf.events[i];
+            //zones that began before traceStart() are dropped, and with
+            //them whatever a thread that has not recorded since still holds
+            if (e.begin < since)
+                continue;
+            double ts = (e.begin - since) * 1e-3;
+            if (e.end != 0)
+                fprintf(fp, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                            "\"ts\": %.3f, \"dur\": %.3f}",
+                        e.name, buf.tid, ts, (e.end - e.begin) * 1e-3);
+            else
+                fprintf(fp, ",\n{\"name\": \"%s\", \"ph\": \"C\", \"pid\": 1, \"tid\": %d, "
+                            "\"ts\": %.3f, \"args\": {\"value\": %g}}",
+                        e.name, buf.tid, ts, e.value);
+        }
+    }
+    fprintf(fp, "\n]}\n");
+    return fclose(fp) == 0;
+}
+
+static void writeAtExit(){
+    traceStop();
+    if (!writeTrace(atExitPath))
+        perror(atExitPath);
+}
+
+/******************************************************************************
+ * fromEnvironment: TERRAIN_TRACE=file records the whole run into file.
+ ******************************************************************************/
+static struct TraceFromEnvironment {
+    TraceFromEnvironment(){
+        atExitPath = getenv("TERRAIN_TRACE");
+        if (atExitPath != NULL && *atExitPath != '\0'){
+            traceStart();
+            atexit(writeAtExit);
+        }
+    }
+} fromEnvironment;
+
+#endif
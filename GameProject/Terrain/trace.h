@@ -0,0 +1,76 @@
+/*! \file trace.h
+ * Phase level tracing. TRACE_ZONE marks the rest of a scope as a named
+ * zone and TRACE_COUNTER records a value; both append to a buffer owned by
+ * the calling thread, so recording takes no lock. The buffers are written
+ * as Chrome trace JSON, which chrome://tracing and Perfetto open, one
+ * track per thread.
+ *
+ * Tracing is compiled in only with TERRAIN_TRACE defined (make TRACE=1
+ * after a make clean); otherwise the macros expand to nothing. A traced
+ * build records once the TERRAIN_TRACE environment variable names the
+ * file to write at exit, or after traceStart().
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#ifdef TERRAIN_TRACE
+
+#include <atomic>
+
+extern std::atomic<bool> traceOn;
+
+/******************************************************************************
+ * traceStart: drops what was recorded so far and starts recording. Safe
+ * while other threads record: each drops its old events itself the next
+ * time it records, and the rest are left out of writeTrace().
+ * traceStop: stops recording and keeps what was recorded.
+ ******************************************************************************/
+void traceStart();
+void traceStop();
+
+/******************************************************************************
+ * writeTrace: writes every thread's events to path as Chrome trace JSON.
+ * Only call it while no thread is recording.
+ ******************************************************************************/
+bool writeTrace(const char *path);
+
+uint64_t traceNow();
+void traceZone(const char *name, uint64_t begin, uint64_t end);
+void traceCounter(const char *name, double value);
+
+/******************************************************************************
+ * TraceZone: records its lifetime. name must outlive the trace, which a
+ * string literal does.
+ ******************************************************************************/
+class TraceZone {
+public:
+    explicit TraceZone(const char *name) : name(name), begin(traceOn.load(std::memory_order_relaxed) ? traceNow() : 0) {}
+    ~TraceZone(){
+        if (begin != 0)
+            traceZone(name, begin, traceNow());
+    }
+    TraceZone(const TraceZone &) = delete;
+    TraceZone &operator=(const TraceZone &) = delete;
+
+private:
+    const char *name;
+    uint64_t begin;
+};
+
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_JOIN(traceZone, __LINE__)(name)
+#define TRACE_COUNTER(name, value) \
+    do { if (traceOn.load(std::memory_order_relaxed)) traceCounter(name, value); } while (0)
+
+#else
+
+#define TRACE_ZONE(name) do {} while (0)
+#define TRACE_COUNTER(name, value) do {} while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,56 @@
+/*! \file batch.cxx
+ * Adaptive triangulation: generates a map with --method (diamond,
+ * midpoint, fault, particle or perlin) and simplifies it to the smallest
+ * network greedy insertion finds within --tolerance of every sample. The
+ * points and triangles against the full grid, the error reached and the
+ * time go to stdout; --output writes the network as a Wavefront OBJ file.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+
+#include "options.h"
+#include "heightmap.h"
+#include "generate.h"
+#include "tin.h"
+
+/******************************************************************************
+ * main: main function for the program.
+ ******************************************************************************/
+int main (int argc, char* argv[]) {
+    const Options defaults = { 1025, (unsigned int)time(NULL), 1000, NULL, NULL,
+                               1, 0, NULL, 0.5f, 0 };
+    Options opts = defaults;
+    double t1,t2;
+
+    if (!parseOptions(argc, argv, opts) || !isPowerOfTwoPlusOne(opts.size) || !(opts.tolerance >= 0.0f)) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+    int size = opts.size;
+    Heightmap map(size);
+    ThreadPool pool(opts.threads);
+    if (!generateByName(opts.method != NULL ? opts.method : "diamond", map, opts, &pool)) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+
+    Tin tin;
+    t1=wallClock();
+    simplify(map, opts.tolerance, tin);
+    t2=wallClock();
+    size_t triangles = tin.triangles.size() / 3, grid = 2UL * (size - 1) * (size - 1);
+    printf("%lu points, %lu triangles of %lu in the grid (%.3f%%), largest error %g\n",
+           (unsigned long)tin.points.size(), (unsigned long)triangles, (unsigned long)grid,
+           100.0 * triangles / grid, tin.error);
+    printf("simplify %f s\n", t2 - t1);
+
+    const float half = (float)(size / 2);
+    if (opts.output != NULL && !writeTinObj(opts.output, tin, -half, -half, 1.0f)) {
+        perror(opts.output);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+/*! \file batch.cxx
+ * Water Erosion Algorithm: headless batch generation. Same generator as main.cxx without
+ * the GLUT window, so it runs on machines with no display or GL libraries.
+ * The generation time goes to stdout and, with --times, to a file.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "options.h"
+#include "heightmap.h"
+#include "mapfile.h"
+#include "fault.h"
+#include "erosion.h"
+
+/******************************************************************************
+ * main: main function for the program.
+ ******************************************************************************/
+int main (int argc, char* argv[]) { 
+    const Options defaults = { 50, (unsigned int)time(NULL), 5000, NULL, NULL,
+                               1, 0, NULL, EROSION_DEFAULTS.tolerance, EROSION_DEFAULTS.levels };
+    Options opts = defaults;
+    double t1,t2;
+
+    ErosionParams params = EROSION_DEFAULTS;
+    if (!parseOptions(argc, argv, opts)
+        || (opts.method != NULL && !erosionMethodByName(opts.method, params.method))) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+    params.tolerance = opts.tolerance;
+    params.levels = opts.levels;
+    int size = opts.size;
+    Heightmap erosion(size);
+    Heightmap water(size);
+    ThreadPool pool(opts.threads);
+
+    faultLines(erosion, opts.seed, 500);
+    t1=wallClock();
+    waterErosion(erosion, water, opts.iterations, &pool, params);
+    t2=wallClock();
+
+    float seconds = t2 - t1;
+    printf("%f\n", seconds);
+    if (opts.times != NULL)
+        appendTime(opts.times, seconds);
+    if (opts.output != NULL && !saveHeightmap(opts.output, erosion, "erosion", opts)) {
+        perror(opts.output);
+        return 1;
+    }
+    return 0;
+}
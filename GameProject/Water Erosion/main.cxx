@@ -9,131 +9,27 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <iostream>
+#define GL_GLEXT_PROTOTYPES    // buffer objects, see meshdraw.h
 #include <GL/freeglut.h>
 #include <math.h>
 #include <time.h>
-#define FLT_MAX     3.40282347E+38F
 
-const int size = 50;          
-const float step = 1.0;                          
-const float MAX_X = step * (size/2);       
-const float MIN_X =  - MAX_X;                       
-const float MAX_Z = step * (size/2);      
-const float MIN_Z =  - MAX_Z;
-const float rand_m = 2147483647.0f; //largest signed integer in 32 bits
+#include "options.h"
+#include "heightmap.h"
+#include "mapfile.h"
+#include "mesh.h"
+#include "meshdraw.h"
+#include "fault.h"
+#include "erosion.h"
 
-float erosion[size][size]; //heightmap array
-float water[size][size]; 
+int size = 50;  // or --size
+const float step = 1.0;
+float MIN_X, MIN_Z; //set once the size is known
 
-/******************************************************************************
- * random: enter a max value and return a random value between -max, and max.
- ******************************************************************************/
-float random(float max){
-    float r = rand();
-    return (r/rand_m) * max - (max * 0.5);
-}
-
-/******************************************************************************
- * initHeightField: uses the Fault-Line Algorithm to write heightmap values to 
- * the array. 
- ******************************************************************************/
-void initHeightField() {
-    erosion[0][0] = MIN_Z + random(2.0f);
-    erosion[0][size-1] = MIN_Z + random(2.0f);
-    erosion[size-1][size-1] = MIN_Z +random(2.0f);
-    erosion[size-1][0] = MIN_Z + random(2.0f);
-
-    float a, b, c;
-    float disp = 0.1f; 
-    float aux; //line formula variables ax + bz = c
-    for (int i = 0; i < 500; i++){
-        a = cos(random(100.0));
-        b = sin(random(100.0));
-        c = ((float)rand() / rand_m) * 2 * sqrt(pow(size, 2)/2)  - sqrt(pow(size, 2)/2); 
-        for (int r = 0; r < size; r++){
-            for (int t = 0; t < size; t++){
-                if ((r - (size/2)) * a + (t - (size/2)) * b + c > 0)
-                    aux = disp;
-                else
-                    aux = -disp;
-                erosion[r][t] += aux;
-            }
-        }
-    }
-}
-
-/******************************************************************************
- * zeroOut: initializing every value in array to 0.0f;
- ******************************************************************************/
-void zeroOut(){
-    for (int i = 0; i < size; i++){
-        for (int j = 0; j < size; j++){
-            water[i][j] = 0.0f;
-        }
-    }
-}
-
-/******************************************************************************
- * initHeightField: simulate water movement due to gravity
- ******************************************************************************/
-void movement(){
-    float curr, diff, max= 0.0f;
-    int low_x, low_y;
-    for(int m = 1; m < (size -1); m++){
-        for(int n = 1; n < (size -1); n++){
-            curr = erosion[m][n] + water[m][n];
-            max = -FLT_MAX;
-            for(int x = -1; x < 2; x += 1){
-                for (int y = -1; y < 2; y += 1){
-                    diff = curr - erosion[m+x][n+y] - water[m+x][n+x];
-                    if(diff > max){
-                        max = diff;
-                        low_x = x;
-                        low_y = y;
-                    }
-                }
-            }
-            if (max > 0.0f)
-            {
-                if(water[m][n] < max)
-                {
-                    water[m+low_x][n+low_y] += water[m][n];
-                    water[m][n] = 0.0f;
-                }
-                else 
-                {
-                    water[m+low_x][n+low_y] += max/2.0f;
-                    water[m][n] -= max/2.0f;
-                }
-            }
-        }
-    }
-}
-
-/******************************************************************************
- * waterErosion: emulates the steps of natural erosion
- * rainfall, erosion, movement.
- ******************************************************************************/
-void waterErosion(int iter){
-    for(int i = 0; i < iter; i++){
-        //it's raining, it's pouring...incrementing each cells with "rain"
-        for (int rainx = 0; rainx < size; rainx++)
-            for (int rainy = 0; rainy < size; rainy++)
-                water[rainx][rainy] += 0.01f;
-        //simulating the "erosion" of height from erosion heightmap
-        for (int solublex = 0; solublex < size; solublex++)
-            for(int solubley = 0; solubley < size; solubley++)
-                erosion[solublex][solubley] -= water[solublex][solubley] * 0.01f;
-        //particle movement
-        movement();
-        for(int r = 0; r < size; r++)
-            for (int c = 0; c < size; c++){
-                float water_lost = water[r][c] * 0.9f;
-                water[r][c] -= water_lost;
-                erosion[r][c] += water_lost * 0.01f;
-            }
-    }   
-}
+Heightmap erosion; //heightmap array
+TerrainMesh mesh;        // built once the heightmap is done
+MeshBuffers buffers;     // mesh as uploaded to GL
+Heightmap water; 
 
 /******************************************************************************
  * display: displays heightmap as 3D terrain
@@ -143,27 +39,8 @@ void display( void ) {
     glClearDepth( 1.0 );
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
     
-    for ( int r = 0; r < size; r++ ) {       
-        float i = MIN_Z + r * step;       
-        for ( int c = 0; c < size; c++ ) {            
-            float j = MIN_X + c * step;
-            if (r < size - 1  &&  c < size - 1  ) {
-                
-                glColor3f( 1.0, 1.0, 1.0 );
-                glBegin( GL_LINE_LOOP );
-                glVertex3f( j, erosion[r][c], i );
-                glVertex3f( j, erosion[r+1][c], i + step );
-                glVertex3f( j + step, erosion[r][c+1], i );
-                glEnd();
-                
-                glBegin( GL_LINE_LOOP );
-                glVertex3f( j + step, erosion[r][c+1], i );
-                glVertex3f( j, erosion[r+1][c], i + step );
-                glVertex3f( j + step, erosion[r+1][c+1], i + step );
-                glEnd();
-            }
-        }
-    }       
+    glColor3f( 1.0, 1.0, 1.0 );
+    buffers.draw();
     glFlush();
 }
 
@@ -178,16 +55,27 @@ void reshape( const int width, const int height) {
  * main: main function for the program.
  ******************************************************************************/
 int main (int argc, char* argv[]) { 
-    time_t beginning = time(NULL);
-    // Writing Files
-    FILE *fp;
-    fp = fopen("erosion1000.txt", "a+");//open for writing 
-    
+    const Options defaults = { size, (unsigned int)time(NULL), 5000, NULL, "erosion1000.txt",
+                               1, 0, NULL, EROSION_DEFAULTS.tolerance, EROSION_DEFAULTS.levels };
+    Options opts = defaults;
     clock_t t1,t2;
     // Initialize windows and input:
 
-    srand(beginning);//set the random seed
     glutInit( &argc, argv );
+    ErosionParams params = EROSION_DEFAULTS;
+    if (!parseOptions(argc, argv, opts)
+        || (opts.method != NULL && !erosionMethodByName(opts.method, params.method))) {
+        usage(argv[0], defaults);
+        return 1;
+    }
+    params.tolerance = opts.tolerance;
+    params.levels = opts.levels;
+    size = opts.size;
+    MIN_X = MIN_Z = - step * (size/2);
+    erosion.allocate(size, size);
+    water.allocate(size, size);
+    ThreadPool pool(opts.threads);
+
     glutInitWindowPosition( 0, 0 );
     glutInitWindowSize( 500, 500 );
     glutInitDisplayMode( GLUT_RGBA | GLUT_SINGLE | GLUT_DEPTH );
@@ -203,16 +91,19 @@ int main (int argc, char* argv[]) {
     glLoadIdentity();
     glFrustum( -1.0, 1.0, -1.0, 1.0, 1.0, 100.0 );
     
-    zeroOut();
-    initHeightField();
+    faultLines(erosion, opts.seed, 500);
     t1=clock();
-    waterErosion(5000);
+    waterErosion(erosion, water, opts.iterations, &pool, params);
     t2=clock();
 
     float diff ((float)t2-(float)t1);
     float seconds = diff / CLOCKS_PER_SEC;
-    fprintf(fp, "%f\n", seconds); 
-    fclose(fp);//closing the file
+    appendTime(opts.times, seconds);
+    if (opts.output != NULL && !saveHeightmap(opts.output, erosion, "erosion", opts))
+        perror(opts.output);
+    mesh.build(erosion, MIN_X, MIN_Z, step);
+    buffers.upload(mesh);
+    glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
     glutMainLoop();
     return 0;
 }
\ No newline at end of file